@@ -0,0 +1,383 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Commands;
+
+use Codewithkyrian\Transformers\PreTrainedTokenizers\AutoTokenizer;
+use Codewithkyrian\Transformers\PreTrainedTokenizers\PreTrainedTokenizer;
+use Codewithkyrian\Transformers\Tokenizers\BPECache;
+use Codewithkyrian\Transformers\Tokenizers\BPEModel;
+use Codewithkyrian\Transformers\Tokenizers\UnigramModel;
+use Codewithkyrian\Transformers\Tokenizers\WordPieceModel;
+use Codewithkyrian\Transformers\Transformers;
+use Codewithkyrian\Transformers\Utils\Hub;
+use Exception;
+use ReflectionClass;
+use Symfony\Component\Console\Attribute\AsCommand;
+use Symfony\Component\Console\Command\Command;
+use Symfony\Component\Console\Input\InputInterface;
+use Symfony\Component\Console\Input\InputOption;
+use Symfony\Component\Console\Output\ConsoleOutputInterface;
+use Symfony\Component\Console\Output\OutputInterface;
+use function Codewithkyrian\Transformers\Utils\basePath;
+
+#[AsCommand(
+    name: 'bench:tokenizers',
+    description: 'Benchmark tokenizer encode/decode throughput, latency and memory.',
+)]
+class TokenizerBenchmarkCommand extends Command
+{
+    /**
+     * Filler used to build the synthetic long inputs, mixing scripts, digits, punctuation and whitespace runs.
+     */
+    protected const LONG_INPUT_SEED = "The quick brown fox jumps over the lazy dog. 1234567890 !?;: "
+    . "Ünïcödé façade naïve café — «quotes» "
+    . "日本語のテキスト 中文文本 한국어 텍스트 "
+    . "Привет, мир! مرحبا بالعالم "
+    . "emoji 🤗🚀 tabs\t\tand  spaces\n\n";
+
+    protected function configure(): void
+    {
+        $this->setHelp(
+            'This command measures encode and decode throughput (docs/s, tokens/s), p50/p99 latency and peak memory '
+            . 'of each tokenizer over the tokenizer test fixtures plus synthetic long inputs, aggregated per tokenizer '
+            . 'family (BPE, byte-level BPE, WordPiece, Unigram). The report is written as JSON.'
+        );
+
+        $this->addOption(
+            'dataset',
+            'd',
+            InputOption::VALUE_REQUIRED | InputOption::VALUE_IS_ARRAY,
+            'A JSON fixture file to take the inputs from, keyed by tokenizer id.',
+            [basePath('tests/tokenizers/dataset-regular.json'), basePath('tests/tokenizers/dataset-templates.json')]
+        );
+
+        $this->addOption(
+            'tokenizer',
+            't',
+            InputOption::VALUE_REQUIRED | InputOption::VALUE_IS_ARRAY,
+            'Only benchmark the given tokenizer ids.'
+        );
+
+        $this->addOption(
+            'iterations',
+            'i',
+            InputOption::VALUE_REQUIRED,
+            'The number of timed passes over the inputs of each tokenizer.',
+            5
+        );
+
+        $this->addOption(
+            'long-length',
+            null,
+            InputOption::VALUE_REQUIRED,
+            'The length in characters of the synthetic long inputs. Zero disables them.',
+            16384
+        );
+
+        $this->addOption(
+            'cache-dir',
+            'c',
+            InputOption::VALUE_OPTIONAL,
+            'The directory the tokenizers are cached in.'
+        );
+
+        $this->addOption(
+            'output',
+            'o',
+            InputOption::VALUE_REQUIRED,
+            'Write the JSON report to this file instead of the standard output.'
+        );
+    }
+
+    protected function execute(InputInterface $input, OutputInterface $output): int
+    {
+        $iterations = max(1, (int)$input->getOption('iterations'));
+        $longLength = max(0, (int)$input->getOption('long-length'));
+        $only = $input->getOption('tokenizer');
+        $cacheDir = $input->getOption('cache-dir');
+        $outputFile = $input->getOption('output');
+
+        // Progress goes to stderr so the JSON report can be piped
+        $log = $output instanceof ConsoleOutputInterface ? $output->getErrorOutput() : $output;
+
+        if ($cacheDir != null) Transformers::setup()->setCacheDir($cacheDir);
+
+        try {
+            $inputs = $this->loadInputs($input->getOption('dataset'));
+        } catch (Exception $e) {
+            $log->writeln("<error>✘ {$e->getMessage()}</error>");
+            return Command::FAILURE;
+        }
+
+        if (!empty($only)) {
+            $inputs = array_intersect_key($inputs, array_flip($only));
+        }
+
+        if (empty($inputs)) {
+            $log->writeln('<error>✘ No tokenizer inputs found.</error>');
+            return Command::FAILURE;
+        }
+
+        $long = $this->longInputs($longLength);
+
+        $tokenizers = [];
+        $families = [];
+
+        foreach ($inputs as $tokenizerId => $texts) {
+            $log->writeln("✔ Benchmarking <info>$tokenizerId</info>");
+
+            try {
+                $result = $this->benchmark($tokenizerId, $texts, $long, $iterations);
+            } catch (Exception $e) {
+                $log->writeln("<error>✘ $tokenizerId: {$e->getMessage()}</error>");
+                $tokenizers[$tokenizerId] = ['error' => $e->getMessage()];
+                continue;
+            }
+
+            $family = $result['family'];
+            foreach (['encode', 'decode'] as $phase) {
+                $families[$family][$phase]['latencies'] = array_merge(
+                    $families[$family][$phase]['latencies'] ?? [],
+                    $result[$phase]['latencies']
+                );
+                $families[$family][$phase]['tokens'] = ($families[$family][$phase]['tokens'] ?? 0) + $result[$phase]['tokens'];
+
+                $result[$phase] = $this->summarize($result[$phase]['latencies'], $result[$phase]['tokens']);
+            }
+            $families[$family]['tokenizers'][] = $tokenizerId;
+            $families[$family]['peak_memory_bytes'] = max($families[$family]['peak_memory_bytes'] ?? 0, $result['peak_memory_bytes']);
+
+            $tokenizers[$tokenizerId] = $result;
+        }
+
+        foreach ($families as $family => $stats) {
+            foreach (['encode', 'decode'] as $phase) {
+                $families[$family][$phase] = $this->summarize($stats[$phase]['latencies'], $stats[$phase]['tokens']);
+            }
+        }
+
+        ksort($families);
+
+        $report = [
+            'environment' => [
+                'php_version' => PHP_VERSION,
+                'os' => PHP_OS_FAMILY,
+                'iterations' => $iterations,
+                'long_input_length' => $longLength,
+                'timestamp' => date(DATE_ATOM),
+            ],
+            'families' => $families,
+            'tokenizers' => $tokenizers,
+            'bpe_cache' => BPECache::allStats(),
+        ];
+
+        $json = json_encode($report, JSON_PRETTY_PRINT | JSON_UNESCAPED_SLASHES | JSON_UNESCAPED_UNICODE);
+
+        if ($outputFile !== null) {
+            if (@file_put_contents($outputFile, $json . PHP_EOL) === false) {
+                $log->writeln("<error>✘ Unable to write the report to $outputFile</error>");
+                return Command::FAILURE;
+            }
+
+            $log->writeln("✔ Report written to <info>$outputFile</info>");
+        } else {
+            $output->writeln($json, OutputInterface::OUTPUT_RAW);
+        }
+
+        return Command::SUCCESS;
+    }
+
+    /**
+     * Collects the input texts of every tokenizer in the fixture files.
+     *
+     * Plain inputs and both sides of text pairs are used as documents. Chat template fixtures contribute their
+     * message contents.
+     *
+     * @param string[] $files
+     *
+     * @return array<string, string[]> The input texts, keyed by tokenizer id.
+     * @throws Exception
+     */
+    protected function loadInputs(array $files): array
+    {
+        $inputs = [];
+
+        foreach ($files as $file) {
+            if (!is_file($file)) {
+                throw new Exception("Dataset file `$file` not found.");
+            }
+
+            $data = json_decode(file_get_contents($file), true);
+
+            if (!is_array($data)) {
+                throw new Exception("Unable to decode dataset file `$file`: " . json_last_error_msg());
+            }
+
+            foreach ($data as $tokenizerId => $tests) {
+                foreach ($tests as $test) {
+                    if (isset($test['messages'])) {
+                        $texts = array_column($test['messages'], 'content');
+                    } elseif (is_string($test['input'] ?? null)) {
+                        $texts = [$test['input']];
+                    } else {
+                        $texts = array_merge((array)($test['input']['text'] ?? []), (array)($test['input']['text_pair'] ?? []));
+                    }
+
+                    foreach ($texts as $text) {
+                        if (is_string($text) && $text !== '') {
+                            $inputs[$tokenizerId][] = $text;
+                        }
+                    }
+                }
+            }
+        }
+
+        return $inputs;
+    }
+
+    /**
+     * @return string[] Synthetic long documents of the given length in characters.
+     */
+    protected function longInputs(int $length): array
+    {
+        if ($length === 0) {
+            return [];
+        }
+
+        $seed = self::LONG_INPUT_SEED;
+        $seedLength = mb_strlen($seed);
+
+        $mixed = mb_substr(str_repeat($seed, intdiv($length, $seedLength) + 1), 0, $length);
+
+        // A single unbroken word stresses the per-word merge loops rather than pre-tokenization
+        $word = str_repeat('a', min($length, 1024));
+
+        return [$mixed, $word];
+    }
+
+    /**
+     * Times encoding and decoding every input with the given tokenizer.
+     *
+     * @param string[] $texts
+     * @param string[] $long
+     *
+     * @return array The family, load time, peak memory and the raw encode/decode latencies and token counts.
+     * @throws Exception
+     */
+    protected function benchmark(string $tokenizerId, array $texts, array $long, int $iterations): array
+    {
+        gc_collect_cycles();
+
+        if (function_exists('memory_reset_peak_usage')) {
+            memory_reset_peak_usage();
+        }
+
+        $baseline = memory_get_usage();
+
+        $start = hrtime(true);
+        $tokenizer = AutoTokenizer::fromPretrained($tokenizerId);
+        $loadTime = (hrtime(true) - $start) / 1e6;
+
+        $documents = array_merge($texts, $long);
+
+        // Warm-up pass, so lazily built tables are not attributed to the first timed document
+        foreach ($documents as $text) {
+            $tokenizer->encode($text);
+        }
+
+        $encode = ['latencies' => [], 'tokens' => 0];
+        $decode = ['latencies' => [], 'tokens' => 0];
+
+        for ($i = 0; $i < $iterations; $i++) {
+            foreach ($documents as $text) {
+                $start = hrtime(true);
+                $ids = $tokenizer->encode($text);
+                $encode['latencies'][] = hrtime(true) - $start;
+                $encode['tokens'] += count($ids);
+
+                if (empty($ids)) {
+                    continue;
+                }
+
+                $start = hrtime(true);
+                $tokenizer->decode($ids);
+                $decode['latencies'][] = hrtime(true) - $start;
+                $decode['tokens'] += count($ids);
+            }
+        }
+
+        return [
+            'family' => $this->family($tokenizerId, $tokenizer),
+            'class' => (new ReflectionClass($tokenizer))->getShortName(),
+            'documents' => count($documents),
+            'load_ms' => round($loadTime, 3),
+            'encode' => $encode,
+            'decode' => $decode,
+            'peak_memory_bytes' => max(0, memory_get_peak_usage() - $baseline),
+        ];
+    }
+
+    /**
+     * Classifies the tokenizer by its model, telling byte-level BPE apart from BPE over characters.
+     */
+    protected function family(string $tokenizerId, PreTrainedTokenizer $tokenizer): string
+    {
+        return match (true) {
+            $tokenizer->model instanceof BPEModel => $this->isByteLevel($tokenizerId) ? 'byte-level' : 'bpe',
+            $tokenizer->model instanceof WordPieceModel => 'wordpiece',
+            $tokenizer->model instanceof UnigramModel => 'unigram',
+            default => 'other',
+        };
+    }
+
+    protected function isByteLevel(string $tokenizerId): bool
+    {
+        $tokenizerJson = Hub::getJson($tokenizerId, 'tokenizer.json', fatal: false);
+
+        if ($tokenizerJson === null) {
+            return false;
+        }
+
+        $components = json_encode([$tokenizerJson['pre_tokenizer'] ?? null, $tokenizerJson['decoder'] ?? null]);
+
+        return str_contains($components, '"ByteLevel"');
+    }
+
+    /**
+     * @param int[] $latencies Per-document latencies in nanoseconds.
+     *
+     * @return array{docs: int, tokens: int, seconds: float, docs_per_second: float, tokens_per_second: float, p50_ms: float, p99_ms: float, max_ms: float}
+     */
+    protected function summarize(array $latencies, int $tokens): array
+    {
+        $count = count($latencies);
+        $seconds = array_sum($latencies) / 1e9;
+
+        sort($latencies);
+
+        $percentile = function (float $p) use ($latencies, $count): float {
+            if ($count === 0) {
+                return 0.0;
+            }
+
+            // Nearest-rank percentile
+            $rank = (int)ceil($p / 100 * $count) - 1;
+
+            return round($latencies[max(0, min($count - 1, $rank))] / 1e6, 4);
+        };
+
+        return [
+            'docs' => $count,
+            'tokens' => $tokens,
+            'seconds' => round($seconds, 6),
+            'docs_per_second' => $seconds > 0 ? round($count / $seconds, 2) : 0.0,
+            'tokens_per_second' => $seconds > 0 ? round($tokens / $seconds, 2) : 0.0,
+            'p50_ms' => $percentile(50),
+            'p99_ms' => $percentile(99),
+            'max_ms' => $count > 0 ? round(end($latencies) / 1e6, 4) : 0.0,
+        ];
+    }
+}
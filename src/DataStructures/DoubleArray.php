@@ -0,0 +1,182 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\DataStructures;
+
+use RuntimeException;
+
+/**
+ * A byte-level double-array trie in the darts-clone unit layout used by SentencePiece.
+ *
+ * Each 32-bit unit packs a label (low 8 bits), a has-leaf flag (bit 8) and the XOR offset to its children
+ * (bits 10-31, scaled by 256 when bit 9 is set). Leaf units carry the key's value with bit 31 set. Lookups
+ * walk the bytes of the input directly, so a common prefix search costs one array read per byte.
+ */
+class DoubleArray
+{
+    /**
+     * @param int[] $units The packed units of the trie.
+     */
+    public function __construct(protected array $units)
+    {
+    }
+
+    /**
+     * Builds a trie from a map of keys to non-negative integer values.
+     *
+     * @param array<string, int> $entries The keys and their values. Empty keys and keys containing NUL bytes are skipped.
+     */
+    public static function build(array $entries): static
+    {
+        $keys = [];
+        $values = [];
+
+        foreach ($entries as $key => $value) {
+            $key = (string)$key;
+
+            if ($key === '' || str_contains($key, "\0")) {
+                continue;
+            }
+
+            $keys[] = $key;
+            $values[] = $value;
+        }
+
+        if (empty($keys)) {
+            return new static([0]);
+        }
+
+        array_multisort($keys, SORT_STRING, $values);
+
+        $size = 256;
+        $units = array_fill(0, $size, 0);
+        $used = array_fill(0, $size, false);
+        $used[0] = true;
+        $usedBases = [];
+        $firstFree = 1;
+
+        // Each entry is a node still to be placed: [position, first key, end of keys, depth]
+        $stack = [[0, 0, count($keys), 0]];
+
+        while (!empty($stack)) {
+            [$position, $begin, $end, $depth] = array_pop($stack);
+
+            // Keys are sorted and unique, so a key ending at this node is always the first one in its range
+            $hasLeaf = strlen($keys[$begin]) === $depth;
+            $labels = [];
+            $ranges = [];
+
+            for ($i = $hasLeaf ? $begin + 1 : $begin; $i < $end;) {
+                $label = ord($keys[$i][$depth]);
+                $j = $i + 1;
+
+                while ($j < $end && ord($keys[$j][$depth]) === $label) {
+                    ++$j;
+                }
+
+                $labels[] = $label;
+                $ranges[] = [$i, $j];
+                $i = $j;
+            }
+
+            // The leaf value lives in the label-0 slot, so it takes part in the search for a free base
+            $slots = $hasLeaf ? [0, ...$labels] : $labels;
+
+            for ($free = $firstFree; ; ++$free) {
+                if ($free < $size && $used[$free]) {
+                    continue;
+                }
+
+                $base = $free ^ $slots[0];
+                $offset = $position ^ $base;
+
+                if (isset($usedBases[$base]) || ($offset >= 1 << 21 && ($offset & 0xFF) !== 0)) {
+                    continue;
+                }
+
+                while ($size <= ($base | 0xFF)) {
+                    $units[] = 0;
+                    $used[] = false;
+                    ++$size;
+                }
+
+                foreach ($slots as $slot) {
+                    if ($used[$base ^ $slot]) {
+                        continue 2;
+                    }
+                }
+
+                break;
+            }
+
+            if ($offset >= 1 << 29) {
+                throw new RuntimeException('The double array is too large to encode its offsets.');
+            }
+
+            $usedBases[$base] = true;
+            $units[$position] |= ($hasLeaf ? 1 << 8 : 0)
+                | ($offset < 1 << 21 ? $offset << 10 : (($offset >> 8) << 10) | (1 << 9));
+
+            if ($hasLeaf) {
+                $used[$base] = true;
+                $units[$base] = $values[$begin] | (1 << 31);
+            }
+
+            foreach ($labels as $k => $label) {
+                $child = $base ^ $label;
+                $used[$child] = true;
+                $units[$child] = $label;
+                $stack[] = [$child, $ranges[$k][0], $ranges[$k][1], $depth + 1];
+            }
+
+            while ($firstFree < $size && $used[$firstFree]) {
+                ++$firstFree;
+            }
+        }
+
+        return new static($units);
+    }
+
+    /**
+     * Finds every key in the trie that is a prefix of `$text` starting at byte `$offset`.
+     *
+     * @param string $text The text to search.
+     * @param int $offset The byte offset to start the search from.
+     *
+     * @return array<int, int> The values of the matching keys, indexed by their byte length, shortest first.
+     */
+    public function commonPrefixSearch(string $text, int $offset = 0): array
+    {
+        $units = $this->units;
+        $length = strlen($text);
+        $results = [];
+
+        $unit = $units[0] ?? 0;
+        $nodePos = ($unit >> 10) << (($unit & (1 << 9)) >> 6);
+
+        for ($i = $offset; $i < $length; ++$i) {
+            $c = ord($text[$i]);
+
+            if ($c === 0) {
+                break;
+            }
+
+            $nodePos ^= $c;
+            $unit = $units[$nodePos] ?? 0;
+
+            if (($unit & ((1 << 31) | 0xFF)) !== $c) {
+                break;
+            }
+
+            $nodePos ^= ($unit >> 10) << (($unit & (1 << 9)) >> 6);
+
+            if (($unit >> 8) & 1) {
+                $results[$i - $offset + 1] = ($units[$nodePos] ?? 0) & ((1 << 31) - 1);
+            }
+        }
+
+        return $results;
+    }
+}
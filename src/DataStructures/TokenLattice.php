@@ -7,21 +7,32 @@ namespace Codewithkyrian\Transformers\DataStructures;
 
 /**
  * A lattice data structure to be used for tokenization.
+ *
+ * Nodes are stored column-wise in flat arrays indexed by node id, and positions are byte offsets into the
+ * sentence. Node 0 is the beginning-of-sentence node and node 1 the end-of-sentence node.
  */
 class TokenLattice
 {
 
-    /** @var int The length of the input sentence. */
+    /** @var int The length of the input sentence in bytes. */
     public int $len;
 
+    /** @var array<int, int|null> The token id of each node. */
+    public array $tokenIds = [];
 
-    /** @var TokenLatticeNode[] An array of nodes representing the lattice nodes. */
-    public array $nodes = [];
+    /** @var int[] The starting byte offset of each node. */
+    public array $positions = [];
 
-    /** @var array An array of nodes representing the beginning nodes in the lattice. */
+    /** @var int[] The byte length of each node. */
+    public array $lengths = [];
+
+    /** @var float[] The score of each node. */
+    public array $scores = [];
+
+    /** @var array<int, int[]> The ids of the nodes beginning at each byte offset. */
     public array $beginNodes = [];
 
-    /** @var array An array of nodes representing the ending nodes in the lattice. */
+    /** @var array<int, int[]> The ids of the nodes ending at each byte offset. */
     public array $endNodes = [];
 
     /**
@@ -36,95 +47,89 @@ class TokenLattice
         public ?int    $bosTokenId,
         public ?int    $eosTokenId)
     {
-        $this->len = mb_strlen($sentence);
-        $this->beginNodes = array_fill(0, $this->len + 1, []);
-        $this->endNodes = array_fill(0, $this->len + 1, []);
+        $this->len = strlen($sentence);
 
-        $bos = new TokenLatticeNode($this->bosTokenId, 0, 0, 0, 0.0);
-        $eos = new TokenLatticeNode($this->eosTokenId, 1, $this->len, 0, 0.0);
+        $this->tokenIds = [$this->bosTokenId, $this->eosTokenId];
+        $this->positions = [0, $this->len];
+        $this->lengths = [0, 0];
+        $this->scores = [0.0, 0.0];
 
-        $this->nodes[] = $bos;
-        $this->nodes[] = $eos;
-        $this->beginNodes[$this->len][] = $eos;
-        $this->endNodes[0][] = $bos;
+        $this->endNodes[0][] = 0;
     }
 
     /**
      * Inserts a new token node into the token lattice.
      *
-     * @param int $pos The starting position of the token.
-     * @param int $length The length of the token.
+     * @param int $pos The starting byte offset of the token.
+     * @param int $length The length of the token in bytes.
      * @param float $score The score of the token.
      * @param int $tokenId The token ID of the token.
      */
     public function insert(int $pos, int $length, float $score, int $tokenId): void
     {
-        $nodeId = count($this->nodes);
-        $node = new TokenLatticeNode($tokenId, $nodeId, $pos, $length, $score);
-        $this->beginNodes[$pos][] = $node;
-        $this->endNodes[$pos + $length][] = $node;
-        $this->nodes[] = $node;
+        $nodeId = count($this->tokenIds);
+        $this->tokenIds[] = $tokenId;
+        $this->positions[] = $pos;
+        $this->lengths[] = $length;
+        $this->scores[] = $score;
+        $this->beginNodes[$pos][] = $nodeId;
+        $this->endNodes[$pos + $length][] = $nodeId;
     }
 
     /**
      * Implements the Viterbi algorithm to compute the most likely sequence of tokens.
      *
-     * @return TokenLatticeNode[] The array of nodes representing the most likely sequence of tokens.
+     * @return int[] The ids of the nodes forming the most likely sequence of tokens.
      */
     public function viterbi(): array
     {
-        $len = $this->len;
-        $pos = 0;
-        while ($pos <= $len) {
-            if (empty($this->beginNodes[$pos])) {
-                return [];
-            }
-            foreach ($this->beginNodes[$pos] as $rnode) {
-                $rnode->prev = null;
+        $beginNodes = $this->beginNodes;
+        $beginNodes[$this->len][] = 1;
+        ksort($beginNodes);
+
+        $scores = $this->scores;
+        $backtraceScores = [0 => 0.0];
+        $prev = [0 => -1];
+
+        foreach ($beginNodes as $pos => $rnodes) {
+            $lnodes = $this->endNodes[$pos] ?? [];
+
+            foreach ($rnodes as $rnode) {
                 $bestScore = 0.0;
-                $bestNode = null;
-                foreach ($this->endNodes[$pos] as $lnode) {
-                    $score = $lnode->backtraceScore + $rnode->score;
-                    if ($bestNode === null || $score > $bestScore) {
-                        $bestNode =  $lnode;
+                $bestNode = -1;
+
+                foreach ($lnodes as $lnode) {
+                    $score = $backtraceScores[$lnode] + $scores[$rnode];
+                    if ($bestNode === -1 || $score > $bestScore) {
+                        $bestNode = $lnode;
                         $bestScore = $score;
                     }
                 }
 
-                if ($bestNode !== null) {
-                    $rnode->prev = $bestNode;
-                    $rnode->backtraceScore = $bestScore;
-                } else {
+                if ($bestNode === -1) {
                     return [];
                 }
+
+                $prev[$rnode] = $bestNode;
+                $backtraceScores[$rnode] = $bestScore;
             }
-            ++$pos;
         }
 
         $results = [];
-        $root = $this->beginNodes[$len][0];
-        $prev = $root->prev;
-        if ($prev === null) {
-            return [];
-        }
-
-        $node = $prev;
-        while ($node->prev !== null) {
+        for ($node = $prev[1]; $node > 0; $node = $prev[$node]) {
             $results[] = $node;
-            $n =  $node;
-            $node =  $n->prev;
         }
 
         return array_reverse($results);
     }
 
     /**
-     * @param TokenLatticeNode $node
-     * @return string The array of nodes representing the most likely sequence of tokens.
+     * @param int $node The id of the node.
+     * @return string The piece of the sentence covered by the node.
      */
-    public function piece(TokenLatticeNode $node): string
+    public function piece(int $node): string
     {
-        return mb_substr($this->sentence, $node->pos, $node->length);
+        return substr($this->sentence, $this->positions[$node], $this->lengths[$node]);
     }
 
     /**
@@ -141,7 +146,6 @@ class TokenLattice
      */
     public function tokenIds(): array
     {
-        $nodes = $this->viterbi();
-        return array_map(fn($x) => $x->tokenId, $nodes);
+        return array_map(fn($x) => $this->tokenIds[$x], $this->viterbi());
     }
 }
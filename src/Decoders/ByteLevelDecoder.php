@@ -270,6 +270,10 @@ class ByteLevelDecoder extends Decoder
         'ÿ' => 255,
     ];
 
+    /**
+     * Contents of the added tokens, for constant-time membership checks while decoding.
+     */
+    protected ?array $addedTokenSet = null;
 
     /**
      * Convert an array of tokens to a string by decoding each byte.
@@ -279,28 +283,40 @@ class ByteLevelDecoder extends Decoder
      */
     public function convertTokensToString(array $tokens): string
     {
-        $text = implode('', $tokens);
-
-        $textArray = preg_split('//u', $text, -1, PREG_SPLIT_NO_EMPTY);
+        $binaryString = strtr(implode('', $tokens), self::unicodeMap());
 
-        $byteArray = array_map(fn($x) => self::UNICODE_TO_BYTES[$x], $textArray);
+        return mb_convert_encoding($binaryString, 'UTF-8');
+    }
 
-        $binaryString = pack('C*', ...$byteArray);
+    /**
+     * Returns the unicode to byte table with raw bytes as values, so a whole string can be mapped back
+     * with a single `strtr` call instead of one lookup per character in PHP.
+     *
+     * @return array<string, string>
+     */
+    public static function unicodeMap(): array
+    {
+        static $unicodeMap = null;
 
-        return mb_convert_encoding($binaryString, 'UTF-8');
+        return $unicodeMap ??= array_combine(
+            array_keys(self::UNICODE_TO_BYTES),
+            array_map('chr', self::UNICODE_TO_BYTES)
+        );
     }
 
     protected function decodeChain(array $tokens): array
     {
         $subTexts = [];
         $currentSubText = [];
+        $addedTokens = $this->addedTokenSet ??= array_fill_keys(
+            array_map(fn (AddedToken $x) => $x->content, $this->addedTokens),
+            true
+        );
 
         foreach ($tokens as $token) {
             // No need to check skip_special_tokens since the tokens are already filtered
 
-            $addedToken = array_filter($this->addedTokens, fn (AddedToken $x) => $x->content === $token);
-
-            if (!empty($addedToken)) {
+            if (isset($addedTokens[$token])) {
                 if (!empty($currentSubText)) {
                     $subTexts[] = $this->convertTokensToString($currentSubText);
                     $currentSubText = [];
@@ -10,8 +10,15 @@ use RuntimeException;
 
 class Libc
 {
+    protected const O_RDONLY = 0;
+    protected const PROT_READ = 0x1;
+    protected const PROT_WRITE = 0x2;
+    protected const MAP_PRIVATE = 0x2;
+
     protected static FFI $ffi;
 
+    protected static ?FFI $mman = null;
+
     public static function version(): string
     {
         return '1.0.0';
@@ -39,6 +46,64 @@ class Libc
         return self::$ffi;
     }
 
+    /**
+     * Returns the FFI instance exposing the POSIX file mapping functions of the running process.
+     */
+    protected static function mman(): FFI
+    {
+        if (PHP_OS_FAMILY === 'Windows') {
+            throw new RuntimeException('Memory-mapped files are not supported on Windows');
+        }
+
+        return self::$mman ??= FFI::cdef("
+            void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+            int munmap(void *addr, size_t length);
+            int open(const char *pathname, int flags, ...);
+            int close(int fd);
+        ");
+    }
+
+    /**
+     * Whether files can be memory-mapped on this platform.
+     */
+    public static function canMapFiles(): bool
+    {
+        return PHP_OS_FAMILY !== 'Windows';
+    }
+
+    /**
+     * Map the first `$length` bytes of a file into memory as a private, copy-on-write mapping.
+     *
+     * @param string $path The file to map.
+     * @param int $length The number of bytes to map.
+     *
+     * @return CData The base address of the mapping. Must be released with `unmapFile()`.
+     */
+    public static function mapFile(string $path, int $length): CData
+    {
+        $ffi = self::mman();
+
+        $fd = $ffi->open($path, self::O_RDONLY);
+        if ($fd < 0) {
+            throw new RuntimeException("Unable to open $path for mapping");
+        }
+
+        $ptr = $ffi->mmap(null, $length, self::PROT_READ | self::PROT_WRITE, self::MAP_PRIVATE, $fd, 0);
+        $ffi->close($fd);
+
+        // MAP_FAILED is ((void *) -1)
+        if ($ptr === null || $ffi->cast('intptr_t', $ptr)->cdata === -1) {
+            throw new RuntimeException("Unable to map $path into memory");
+        }
+
+        return $ptr;
+    }
+
+    public static function unmapFile(CData $ptr, int $length): void
+    {
+        self::mman()->munmap($ptr, $length);
+    }
+
     public static function new($type, bool $owned = true, bool $persistent = false): ?CData
     {
         return self::ffi()->new($type, $owned, $persistent);
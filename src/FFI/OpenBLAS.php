@@ -4,6 +4,8 @@ declare(strict_types=1);
 
 namespace Codewithkyrian\Transformers\FFI;
 
+use function Codewithkyrian\Transformers\Utils\joinPaths;
+
 /**
  * OpenBLAS - Wrapper for the OpenBLAS library
  * 
@@ -32,4 +34,12 @@ class OpenBLAS extends NativeLibrary
     {
         return '0.3.28';
     }
+
+    /**
+     * Get the path to the LAPACKE header, whose functions are exported by the same library.
+     */
+    public function getLapackeHeaderPath(): string
+    {
+        return joinPaths($this->getIncludeDirectory(), 'lapacke.h');
+    }
 }
@@ -5,6 +5,7 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers\FFI;
 
 use Exception;
+use FFI;
 use FFI\CData;
 use RuntimeException;
 
@@ -63,6 +64,28 @@ class Sndfile extends NativeLibrary
         return $handle;
     }
 
+    /**
+     * Opens a sound file through virtual I/O callbacks.
+     *
+     * @param CData $virtualIo The SF_VIRTUAL_IO struct holding the callbacks.
+     * @param int $mode The mode to open the file in.
+     * @param CData|null $info The info struct to fill.
+     *
+     * @return CData|null The SNDFILE handle, or null if the file could not be opened.
+     * @throws Exception
+     */
+    public function openVirtual(CData $virtualIo, int $mode, ?CData $info = null): ?CData
+    {
+        $info ??= $this->new('SF_INFO');
+        $handle = $this->ffi->{'sf_open_virtual'}(FFI::addr($virtualIo), $mode, $info, null);
+
+        if ($handle === null) {
+            throw new RuntimeException($this->ffi->{'sf_strerror'}(null));
+        }
+
+        return $handle;
+    }
+
     /**
      * Reads frames from a sound file.
      *
@@ -45,11 +45,12 @@ class TransformersUtils extends NativeLibrary
      * @param mixed $input The input array
      * @param int $length The length of the input array
      * @param int $paddedLength The length of the padded array
+     * @param CData|null $padded The buffer to write the padded array to. Allocated if not given.
      * @return CData The padded array
      */
-    public function padReflect($input, int $length, int $paddedLength): CData
+    public function padReflect($input, int $length, int $paddedLength, ?CData $padded = null): CData
     {
-        $padded = $this->new("float[$paddedLength]");
+        $padded ??= $this->new("float[$paddedLength]");
         $this->ffi->{'pad_reflect'}($input, $length, $padded, $paddedLength);
 
         return $padded;
@@ -78,16 +79,17 @@ class TransformersUtils extends NativeLibrary
      * @param bool|null $removeDcOffset Whether to remove DC offset
      * @param bool $doPad Whether to pad
      * @param bool $transpose Whether to transpose
+     * @param CData|null $spectrogram The buffer to write the spectrogram to. Allocated if not given.
      * @return CData The spectrogram
      */
     public function spectrogram(
         $waveform, int $waveformLength, int $spectrogramLength, int $hopLength, int $fftLength,
         $window, int $windowLength, int $d1, int $d1Max, float $power, bool $center, float $preemphasis,
         $melFilters, int $nMelFilters, $nFreqBins, float $melFloor, int $logMel, ?bool $removeDcOffset,
-        bool $doPad, bool $transpose
+        bool $doPad, bool $transpose, ?CData $spectrogram = null
     ): CData
     {
-        $spectrogram = $this->new("float[$spectrogramLength]");
+        $spectrogram ??= $this->new("float[$spectrogramLength]");
 
         $this->ffi->{'spectrogram'}(
             $waveform, $waveformLength, $spectrogram, $spectrogramLength, $hopLength, $fftLength, $window,
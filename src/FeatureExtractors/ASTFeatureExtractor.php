@@ -7,14 +7,16 @@ namespace Codewithkyrian\Transformers\FeatureExtractors;
 
 use Codewithkyrian\Transformers\Tensor\Tensor;
 use Codewithkyrian\Transformers\Utils\Audio;
+use Codewithkyrian\Transformers\Utils\SpectrogramContext;
 use function Codewithkyrian\Transformers\Utils\timeUsage;
 
 class ASTFeatureExtractor extends FeatureExtractor
 {
-    protected array $melFilters;
+    protected Tensor $melFilters;
     protected Tensor $window;
     protected mixed $mean;
     protected mixed $std;
+    protected SpectrogramContext $spectrogram;
 
     public function __construct(array $config)
     {
@@ -22,7 +24,8 @@ class ASTFeatureExtractor extends FeatureExtractor
 
         $samplingRate = $config['sampling_rate'];
 
-        $this->melFilters = Audio::melFilterBank(
+        // Padded with a zero column up to the 257 bins of the 512-point FFT, and shared by every extractor
+        $this->melFilters = Audio::melFilterTensor(
             256,
             $config['num_mel_bins'],
             20,
@@ -30,29 +33,13 @@ class ASTFeatureExtractor extends FeatureExtractor
             $samplingRate,
             null,
             "kaldi",
-            true
+            true,
+            width: 257
         );
 
-        // Do padding:
-        for ($i = 0; $i < count($this->melFilters); $i++) {
-            $this->melFilters[$i][] = 0;
-        }
-
         $this->window = Audio::windowFunction(400, 'hann', false);
 
-        $this->mean = $config['mean'];
-        $this->std = $config['std'];
-    }
-
-    /**
-     *  Extracts features from a given audio using the provided configuration.
-     * @param Tensor $input The audio tensor to extract features from.
-     * @return Tensor[] The extracted features.
-     */
-    public function __invoke($input, ...$args): array
-    {
-        $features = Audio::spectrogram(
-            $input,
+        $this->spectrogram = new SpectrogramContext(
             $this->window,
             frameLength: 400,
             hopLength: 160,
@@ -68,6 +55,19 @@ class ASTFeatureExtractor extends FeatureExtractor
             transpose: true
         );
 
+        $this->mean = $config['mean'];
+        $this->std = $config['std'];
+    }
+
+    /**
+     *  Extracts features from a given audio using the provided configuration.
+     * @param Tensor $input The audio tensor to extract features from.
+     * @return Tensor[] The extracted features.
+     */
+    public function __invoke($input, ...$args): array
+    {
+        $features = $this->spectrogram->compute($input);
+
         return [
             'input_values' => $features->add(-$this->mean)->multiply(1 / $this->std)->unsqueeze(0)
         ];
@@ -6,8 +6,12 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers\FeatureExtractors;
 
 use Codewithkyrian\Transformers\Tensor\Tensor;
+use Codewithkyrian\Transformers\Transformers;
 use Codewithkyrian\Transformers\Utils\Image;
+use Codewithkyrian\Transformers\Utils\ImageDriver;
 use Exception;
+use Imagick;
+use function Codewithkyrian\Transformers\Utils\forkMap;
 
 class ImageFeatureExtractor extends FeatureExtractor
 {
@@ -335,40 +339,7 @@ class ImageFeatureExtractor extends FeatureExtractor
 
         $imageTensor = $image->toTensor();
 
-        if ($this->doRescale) {
-            $imageTensor = $imageTensor->multiply($this->rescaleFactor);
-        }
-
-        if ($doNormalize ?? $this->doNormalize) {
-            if (is_array($this->imageMean)) {
-                // Negate the mean values to add instead of subtract
-                $negatedMean = array_map(fn($mean) => -$mean, $this->imageMean);
-                $imageMean = Tensor::repeat($negatedMean, $image->height() * $image->width(), 1);
-            } else {
-                $imageMean = Tensor::fill([$image->channels * $image->height() * $image->width()], -$this->imageMean);
-            }
-
-
-            if (is_array($this->imageStd)) {
-                // Inverse the standard deviation values to multiple instead of divide
-                $inversedStd = array_map(fn($std) => 1 / $std, $this->imageStd);
-                $imageStd = Tensor::repeat($inversedStd, $image->height() * $image->width(), 1);
-            } else {
-                $imageStd = Tensor::fill([$image->channels * $image->height() * $image->width()], 1 / $this->imageStd);
-            }
-
-
-            // Reshape mean and std to match the image tensor shape
-            $imageMean = $imageMean->reshape($imageTensor->shape());
-            $imageStd = $imageStd->reshape($imageTensor->shape());
-
-            if (count($imageMean) !== $image->channels || count($imageStd) !== $image->channels) {
-                throw new Exception("When set to arrays, the length of `imageMean` (" . count($imageMean) . ") and `imageStd` (" . count($imageStd) . ") must match the number of channels in the image ({$image->channels}).");
-            }
-
-            // Normalize pixel data
-            $imageTensor = $imageTensor->add($imageMean)->multiply($imageStd);
-        }
+        $imageTensor = $this->rescaleAndNormalize($imageTensor, $doNormalize ?? $this->doNormalize);
 
         // Perform padding after rescaling/normalizing
         if ($doPad ?? $this->doPad) {
@@ -387,10 +358,62 @@ class ImageFeatureExtractor extends FeatureExtractor
         ];
     }
 
+    /**
+     * Rescales and normalizes a CHW image tensor in place.
+     *
+     * Rescaling and normalization are folded into a single scale and offset per channel,
+     * `(x * rescaleFactor - mean) / std = x * (rescaleFactor / std) - mean / std`, applied to each
+     * channel plane with one BLAS pass instead of building full-size mean and std tensors.
+     *
+     * @param Tensor $imageTensor The float32 pixel data, in CHW format.
+     * @param bool|null $doNormalize Whether to normalize the pixel data.
+     *
+     * @return Tensor The same tensor, rescaled and normalized.
+     * @throws Exception If the mean or std arrays don't match the number of channels.
+     */
+    protected function rescaleAndNormalize(Tensor $imageTensor, ?bool $doNormalize): Tensor
+    {
+        if (!$this->doRescale && !$doNormalize) {
+            return $imageTensor;
+        }
+
+        [$channels, $height, $width] = $imageTensor->shape();
+        $planeSize = $height * $width;
+
+        $rescale = $this->doRescale ? $this->rescaleFactor : 1.0;
+        $scales = array_fill(0, $channels, $rescale);
+        $offsets = array_fill(0, $channels, 0.0);
+
+        if ($doNormalize) {
+            $mean = is_array($this->imageMean) ? $this->imageMean : array_fill(0, $channels, $this->imageMean);
+            $std = is_array($this->imageStd) ? $this->imageStd : array_fill(0, $channels, $this->imageStd);
+
+            if (count($mean) !== $channels || count($std) !== $channels) {
+                throw new Exception("When set to arrays, the length of `imageMean` (" . count($mean) . ") and `imageStd` (" . count($std) . ") must match the number of channels in the image ($channels).");
+            }
+
+            for ($c = 0; $c < $channels; ++$c) {
+                $scales[$c] = $rescale / $std[$c];
+                $offsets[$c] = -$mean[$c] / $std[$c];
+            }
+        }
+
+        $la = Tensor::mo()->la();
+
+        for ($c = 0; $c < $channels; ++$c) {
+            $plane = new Tensor($imageTensor->buffer(), $imageTensor->dtype(), [$planeSize], $imageTensor->offset() + $c * $planeSize);
+
+            // x := scale * x + offset
+            $la->increment($plane, $offsets[$c], $scales[$c]);
+        }
+
+        return $imageTensor;
+    }
+
     /**
      * Calls the feature extraction process on an array of images,
-     * preprocesses each image, and concatenates the resulting
-     * features into a single Tensor.
+     * preprocesses each image, and writes the resulting features
+     * into their slot of a single Tensor.
      *
      * @param Image|Image[] $input The image(s) to extract features from.
      * @param mixed ...$args Additional arguments.
@@ -399,25 +422,90 @@ class ImageFeatureExtractor extends FeatureExtractor
      */
     public function __invoke($input, ...$args): array
     {
-        $images = is_array($input) ? $input : [$input];
+        $images = is_array($input) ? array_values($input) : [$input];
 
         if (count($images) === 0) {
             throw new Exception('No images provided');
         }
 
-        $imageData = array_map([$this, 'preprocess'], $images);
-
-        $pixelValues = array_column($imageData, 'pixel_values');
-        $originalSizes = array_column($imageData, 'original_size');
-        $reshapedInputSizes = array_column($imageData, 'reshaped_input_size');
+        [$pixelValues, $originalSizes, $reshapedInputSizes] = $this->preprocessBatch($images);
 
         return [
-            'pixel_values' => Tensor::stack($pixelValues),
+            'pixel_values' => $pixelValues,
             'original_sizes' => $originalSizes,
             'reshaped_input_sizes' => $reshapedInputSizes
         ];
     }
 
+    /**
+     * Preprocesses a batch of images into a `[N, ...]` tensor, one slot per image.
+     *
+     * In-process, each image is written into its slot as soon as it is preprocessed, so only one image's
+     * intermediate tensors are alive at a time. When image workers are configured, the batch is split across
+     * forked worker processes that decode and preprocess their share. With the VIPS driver, images are always
+     * preprocessed in-process, since libvips already runs each operation on its own thread pool, which does not
+     * survive a fork.
+     *
+     * @param Image[] $images
+     *
+     * @return array{0: Tensor, 1: array, 2: array} The pixel values, original sizes and reshaped input sizes.
+     * @throws Exception If the images don't all preprocess to the same shape.
+     */
+    protected function preprocessBatch(array $images): array
+    {
+        $images = array_values($images);
+        $workers = Transformers::getImageDriver() === ImageDriver::VIPS ? 1 : Transformers::getImageWorkers();
+
+        $pixelValues = null;
+        $originalSizes = [];
+        $reshapedInputSizes = [];
+
+        $preprocess = function (Image $image) {
+            $imageData = $this->preprocess($image);
+
+            return [$imageData['original_size'], $imageData['reshaped_input_size'], $imageData['pixel_values']];
+        };
+
+        // The batch is allocated with the shape of the first image
+        $store = function (int $i, array $result) use (&$pixelValues, &$originalSizes, &$reshapedInputSizes, $images) {
+            [$originalSizes[$i], $reshapedInputSizes[$i], $pixels] = $result;
+
+            $shape = $pixels->shape();
+            $pixelValues ??= new Tensor(null, Tensor::float32, [count($images), ...$shape]);
+            $batchShape = array_slice($pixelValues->shape(), 1);
+
+            if ($shape !== $batchShape) {
+                throw new Exception("All images in a batch must preprocess to the same shape, got [" . implode(', ', $batchShape) . "] and [" . implode(', ', $shape) . "].");
+            }
+
+            $pixels->to(Tensor::float32)->copyTo(new Tensor($pixelValues->buffer(), Tensor::float32, $shape, $i * array_product($shape)));
+        };
+
+        if (min($workers, count($images)) < 2 || !function_exists('pcntl_fork')) {
+            foreach ($images as $i => $image) {
+                $store($i, $preprocess($image));
+            }
+        } else {
+            $parent = getmypid();
+
+            $results = forkMap($images, $workers, function (array $chunk) use ($parent, $preprocess) {
+                // ImageMagick's OpenMP threads don't survive a fork either
+                if (getmypid() !== $parent && class_exists(Imagick::class)) {
+                    Imagick::setResourceLimit(Imagick::RESOURCETYPE_THREAD, 1);
+                }
+
+                return array_map($preprocess, $chunk);
+            });
+
+            foreach ($results as $i => $result) {
+                $store($i, $result);
+                unset($results[$i]);
+            }
+        }
+
+        return [$pixelValues, $originalSizes, $reshapedInputSizes];
+    }
+
     /**
      * Rounds the height and width down to the closest multiple of size_divisibility
      *
@@ -6,39 +6,94 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers\FeatureExtractors;
 
 use Codewithkyrian\Transformers\Tensor\Tensor;
+use InvalidArgumentException;
 use function Codewithkyrian\Transformers\Utils\timeUsage;
 
 class Wav2Vec2FeatureExtractor extends FeatureExtractor
 {
     /**
      *  Extracts features from a given audio using the provided configuration.
-     * @param Tensor $waveform The audio tensor to extract features from.
-     * @return Tensor[] The extracted features.
+     * @param Tensor|Tensor[] $waveform The audio tensor to extract features from, or a batch of audio tensors of any
+     *  length, which are padded with zeros to the longest one.
+     * @return Tensor[] The extracted features, of shape `[batch, length]`, and the attention mask of the padding.
      */
-    public function __invoke(Tensor $waveform): array
+    public function __invoke(Tensor|array $waveform): array
     {
-        // zero-mean and unit-variance normalization
-        if ($this->config['do_normalize'])
-        {
-            $mean = $waveform->mean();
-
-            //calculate the variance
-//            $variance = $waveform->add(-$mean)->pow(2)->mean();
-            $variance = 0;
-            for ($i = 0; $i < $waveform->size(); $i++) {
-                $variance += pow($waveform[$i] - $mean, 2);
-            }
-            $variance /= $waveform->size();
+        $waveforms = is_array($waveform) ? array_values($waveform) : [$waveform];
 
-            //normalize the waveform
-            $waveform = $waveform->add(-$mean)->multiply(1.0 / sqrt($variance + 1e-7));
+        if (empty($waveforms)) {
+            throw new InvalidArgumentException("Cannot extract features from an empty batch");
         }
 
-        $shape = [1, $waveform->size()];
+        $lengths = array_map(fn(Tensor $waveform) => $waveform->size(), $waveforms);
+        $maxLength = max($lengths);
+        $batchSize = count($waveforms);
+
+        $inputValues = new Tensor(null, Tensor::float32, [$batchSize, $maxLength]);
+        $attentionMask = '';
+
+        foreach ($waveforms as $i => $item) {
+            $length = $lengths[$i];
+
+            $attentionMask .= str_repeat(pack('q', 1), $length) . str_repeat(pack('q', 0), $maxLength - $length);
+
+            if ($length === 0) {
+                continue;
+            }
+
+            // The waveform is copied into its row of the batch and normalized there, leaving the padding at zero
+            $row = new Tensor($inputValues->buffer(), Tensor::float32, [$length], $i * $maxLength);
+            ($item->dtype() === Tensor::float32 ? $item : $item->to(Tensor::float32))->reshape([$length])->copyTo($row);
+
+            if ($this->config['do_normalize']) {
+                self::normalize($row);
+            }
+        }
 
         return [
-            'input_values' => $waveform->reshape($shape),
-            'attention_mask' => Tensor::ones($shape, dtype: Tensor::int64)
+            'input_values' => $inputValues,
+            'attention_mask' => Tensor::fromString($attentionMask, Tensor::int64, [$batchSize, $maxLength])
         ];
     }
-}
\ No newline at end of file
+
+    /**
+     * Extracts features from blocks of audio, e.g. those yielded by `Audio::stream()`.
+     *
+     * @param iterable<Tensor> $blocks 1D float32 blocks of audio at `sampling_rate`.
+     * @return Tensor[] The extracted features.
+     */
+    public function extractStream(iterable $blocks): array
+    {
+        $parts = [];
+
+        foreach ($blocks as $block) {
+            if ($block->size() > 0) {
+                $parts[] = $block;
+            }
+        }
+
+        if (empty($parts)) {
+            throw new InvalidArgumentException("Cannot extract features from empty audio");
+        }
+
+        return $this->__invoke(count($parts) === 1 ? $parts[0] : Tensor::concat($parts));
+    }
+
+    /**
+     * Normalizes a waveform to zero mean and unit variance, in place.
+     *
+     * The mean is a single BLAS reduction, and the variance the dot product of the centered waveform with itself,
+     * so no sample is visited from PHP and the variance does not suffer from the cancellation of `E[x²] - E[x]²`.
+     */
+    protected static function normalize(Tensor $waveform): void
+    {
+        $length = $waveform->size();
+        $mean = $waveform->sum() / $length;
+
+        $waveform->add(-$mean);
+
+        $variance = $waveform->dot($waveform) / $length;
+
+        $waveform->multiply(1.0 / sqrt($variance + 1e-7));
+    }
+}
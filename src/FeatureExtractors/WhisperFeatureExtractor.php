@@ -7,17 +7,29 @@ namespace Codewithkyrian\Transformers\FeatureExtractors;
 
 use Codewithkyrian\Transformers\Tensor\Tensor;
 use Codewithkyrian\Transformers\Utils\Audio;
+use Codewithkyrian\Transformers\Utils\SpectrogramContext;
+use Codewithkyrian\Transformers\Utils\SpectrogramStream;
 use Codewithkyrian\Transformers\Transformers;
+use FFI;
+use Generator;
 
 class WhisperFeatureExtractor extends FeatureExtractor
 {
     protected Tensor $window;
 
+    protected Tensor|array $melFilters;
+
+    protected SpectrogramContext $spectrogram;
+
+    /** Uncentered context used by spectrogram streams, created on first use. */
+    protected ?SpectrogramContext $streamingSpectrogram = null;
+
     public function __construct(array $config)
     {
         parent::__construct($config);
 
-        $this->config['mel_filters'] ??= Audio::melFilterBank(
+        // Filter banks and windows are shared by every extractor with the same configuration
+        $this->melFilters = $config['mel_filters'] ?? Audio::melFilterTensor(
             (int)(1 + $config['n_fft'] / 2),
             nMelFilters: $config['feature_size'],
             minFrequency: 0,
@@ -28,48 +40,149 @@ class WhisperFeatureExtractor extends FeatureExtractor
         );
 
         $this->window = Audio::windowFunction($config['n_fft'], 'hann', false);
+
+        $this->spectrogram = new SpectrogramContext(
+            $this->window,
+            frameLength: $this->config['n_fft'],
+            hopLength: $this->config['hop_length'],
+            power: 2.0,
+            melFilters: $this->melFilters,
+            logMel: 'log10',
+            maxNumFrames: $this->config['nb_max_frames'],
+        );
     }
 
     /**
      *  Extracts features from a given audio using the provided configuration.
-     * @param Tensor $input The audio tensor to extract features from.
-     * @return Tensor[] The extracted features.
+     * @param Tensor|Tensor[] $input The audio tensor to extract features from, or a batch of audio tensors
+     *  (e.g. the chunks of a long recording) to extract features from together.
+     * @return Tensor[] The extracted features, of shape `[batch, feature_size, nb_max_frames]`.
      */
     public function __invoke($input, ...$args): array
     {
-        if ($input->size() > $this->config['n_samples']) {
-            $logger = Transformers::getLogger();
-            $logger->warning('Attempting to extract features for audio longer than 30 seconds.' .
-                'If using a pipeline to extract transcript from a long audio clip,' .
-                'remember to specify `chunkLengthSecs` and/or `strideLengthSecs` in the pipeline options.');
+        $inputs = is_array($input) ? array_values($input) : [$input];
 
-            $input = $input->sliceWithBounds([0], [$this->config['n_samples']]);
-        } else if ($input->size() < $this->config['n_samples']) {
-            $padLength = $this->config['n_samples'] - $input->size();
-            $padding = Tensor::zeros([$padLength], dtype: $input->dtype());
-            $input = Tensor::concat([$input, $padding]);
+        foreach ($inputs as $i => $waveform) {
+            $inputs[$i] = $this->fitToLength($waveform);
         }
 
-        $features = Audio::spectrogram(
-            $input,
+        $features = $this->spectrogram->computeBatch($inputs);
+
+        // Each item is normalized against its own maximum, in place on its view of the batch
+        for ($i = 0; $i < count($inputs); $i++) {
+            $item = $features[$i];
+
+            $item->maximum($item->max() - 8.0)
+                ->add(4.0)
+                ->multiply(1.0 / 4.0);
+        }
+
+        return [
+            'input_features' => $features
+        ];
+    }
+
+    /**
+     * Creates a stream computing log-mel frames as audio blocks arrive.
+     */
+    public function spectrogramStream(): SpectrogramStream
+    {
+        $this->streamingSpectrogram ??= new SpectrogramContext(
             $this->window,
             frameLength: $this->config['n_fft'],
             hopLength: $this->config['hop_length'],
             power: 2.0,
-            melFilters: $this->config['mel_filters'],
+            center: false,
+            melFilters: $this->melFilters,
             logMel: 'log10',
-            maxNumFrames: $this->config['nb_max_frames'],
         );
 
-        $maxValue = $features->max();
+        return new SpectrogramStream($this->streamingSpectrogram);
+    }
 
-        $features = $features
-            ->maximum($maxValue - 8.0)
+    /**
+     * Computes log-mel frames incrementally from blocks of audio, e.g. those yielded by `Audio::stream()`.
+     *
+     * @param iterable<Tensor> $blocks 1D float32 blocks of audio at `sampling_rate`.
+     * @return Generator<Tensor> Unnormalized log-mel frames, of shape `[feature_size, frames]`.
+     */
+    public function extractFrames(iterable $blocks): Generator
+    {
+        $stream = $this->spectrogramStream();
+
+        foreach ($blocks as $block) {
+            $frames = $stream->push($block);
+
+            if ($frames !== null) {
+                yield $frames;
+            }
+        }
+
+        $frames = $stream->finish();
+
+        if ($frames !== null) {
+            yield $frames;
+        }
+    }
+
+    /**
+     * Turns frames from `extractFrames()` into model inputs, as `__invoke()` would for the whole audio.
+     *
+     * Audio shorter than `n_samples` is padded with the log-mel value of silence rather than re-running the STFT
+     * over zero-padded audio, so only the frames at the very end of the audio may differ slightly.
+     *
+     * @param Tensor|Tensor[] $frames The log-mel frames, or the blocks of frames as they were yielded.
+     * @return Tensor[] The extracted features, of shape `[1, feature_size, nb_max_frames]`.
+     */
+    public function framesToFeatures(Tensor|array $frames): array
+    {
+        $frames = is_array($frames) ? Tensor::concat(array_values($frames), 1) : $frames;
+
+        [$numMelFilters, $numFrames] = $frames->shape();
+        $maxNumFrames = $this->config['nb_max_frames'];
+
+        $features = new Tensor(null, Tensor::float32, [1, $numMelFilters, $maxNumFrames]);
+        $silence = log10($this->spectrogram->melFloor);
+
+        for ($i = 0; $i < $numMelFilters; $i++) {
+            $row = $features[0][$i];
+
+            if ($numFrames < $maxNumFrames) {
+                $row->add($silence);
+            }
+
+            $count = min($numFrames, $maxNumFrames);
+            FFI::memcpy($row->buffer()->addr($row->offset()), $frames->buffer()->addr($frames->offset() + $i * $numFrames), $count * 4);
+        }
+
+        $item = $features[0];
+        $item->maximum($item->max() - 8.0)
             ->add(4.0)
             ->multiply(1.0 / 4.0);
 
         return [
-            'input_features' => $features->unsqueeze(0)
+            'input_features' => $features
         ];
     }
+
+    /**
+     * Truncates or zero-pads the audio to `n_samples`.
+     */
+    protected function fitToLength(Tensor $input): Tensor
+    {
+        if ($input->size() > $this->config['n_samples']) {
+            $logger = Transformers::getLogger();
+            $logger->warning('Attempting to extract features for audio longer than 30 seconds.' .
+                'If using a pipeline to extract transcript from a long audio clip,' .
+                'remember to specify `chunkLengthSecs` and/or `strideLengthSecs` in the pipeline options.');
+
+            $input = $input->sliceWithBounds([0], [$this->config['n_samples']]);
+        } else if ($input->size() < $this->config['n_samples']) {
+            $padLength = $this->config['n_samples'] - $input->size();
+            $padding = Tensor::zeros([$padLength], dtype: $input->dtype());
+            $input = Tensor::concat([$input, $padding]);
+        }
+
+        return $input;
+    }
 }
@@ -28,7 +28,7 @@ class ForcedBOSTokenLogitsProcessor extends LogitsProcessor
             if (count($inputIds[$i]) === 1) {
                 $batchLogits = $logits[$i];
                 Tensor::mo()->la()->fill(-INF, $batchLogits);
-                $batchLogits->buffer()[$this->bosTokenId] = 0;
+                $batchLogits->buffer()[$batchLogits->offset() + $this->bosTokenId] = 0;
             }
         }
         return $logits;
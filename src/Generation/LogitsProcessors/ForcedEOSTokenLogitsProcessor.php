@@ -21,9 +21,12 @@ class ForcedEOSTokenLogitsProcessor extends LogitsProcessor
 
     public function __invoke(array $inputIds, Tensor $logits): Tensor
     {
-        if (count($inputIds) >= $this->maxLength) {
-            Tensor::mo()->la()->fill(-INF, $logits);
-            $logits->buffer()[$this->forcedEosTokenId] = 0;
+        for ($i = 0; $i < count($inputIds); $i++) {
+            if (count($inputIds[$i]) >= $this->maxLength - 1) {
+                $batchLogits = $logits[$i];
+                Tensor::mo()->la()->fill(-INF, $batchLogits);
+                $batchLogits->buffer()[$batchLogits->offset() + $this->forcedEosTokenId] = 0;
+            }
         }
         return $logits;
     }
@@ -36,7 +36,7 @@ class MinLengthLogitsProcessor extends LogitsProcessor
             if (count($inputIds[$i]) < $this->minLength) {
                 $batchLogits = $logits[$i];
                 foreach ($this->eosTokenId as $id) {
-                    $batchLogits->buffer()[$id] = -INF;
+                    $batchLogits->buffer()[$batchLogits->offset() + $id] = -INF;
                 }
             }
         }
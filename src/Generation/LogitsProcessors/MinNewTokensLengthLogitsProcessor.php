@@ -31,7 +31,7 @@ class MinNewTokensLengthLogitsProcessor extends LogitsProcessor
                 $batchLogits = $logits[$i];
                 
                 foreach ($this->eosTokenId as $eosTokenId) {
-                    $batchLogits->buffer()[$eosTokenId] = -INF;
+                    $batchLogits->buffer()[$batchLogits->offset() + $eosTokenId] = -INF;
                 }
             }
         }
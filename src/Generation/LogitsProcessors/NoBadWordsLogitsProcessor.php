@@ -48,7 +48,7 @@ class NoBadWordsLogitsProcessor extends LogitsProcessor
                 }
 
                 if ($mark) {
-                    $batchLogits->buffer()[$badWordIds[count($badWordIds) - 1]] = -INF;
+                    $batchLogits->buffer()[$batchLogits->offset() + $badWordIds[count($badWordIds) - 1]] = -INF;
                 }
             }
         }
@@ -79,10 +79,13 @@ class NoRepeatNGramLogitsProcessor extends LogitsProcessor
      */
     public function __invoke(array $inputIds, Tensor $logits): Tensor
     {
-        $bannedTokens = $this->calcBannedNgramTokens($inputIds);
+        for ($i = 0; $i < count($inputIds); $i++) {
+            $batchLogits = $logits[$i];
+            $bannedTokens = $this->calcBannedNgramTokens($inputIds[$i]);
 
-        foreach ($bannedTokens as $token) {
-            $logits->buffer()[$token] = -INF;
+            foreach ($bannedTokens as $token) {
+                $batchLogits->buffer()[$batchLogits->offset() + $token] = -INF;
+            }
         }
 
         return $logits;
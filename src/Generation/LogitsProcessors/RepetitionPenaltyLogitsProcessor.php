@@ -23,11 +23,16 @@ class RepetitionPenaltyLogitsProcessor extends LogitsProcessor
         // As a consequence, the logits corresponding to tokens that appear
         // many times in the output will be penalised more.
         for ($i = 0; $i < count($inputIds); $i++) {
+            $batchLogits = $logits[$i];
+            $buffer = $batchLogits->buffer();
+
             foreach ($inputIds[$i] as $inputId) {
-                if ($logits[$i]->buffer()[$inputId] < 0) {
-                    $logits[$i]->buffer()[$inputId] *= $this->penalty;
+                $index = $batchLogits->offset() + $inputId;
+
+                if ($buffer[$index] < 0) {
+                    $buffer[$index] *= $this->penalty;
                 } else {
-                    $logits[$i]->buffer()[$inputId] /= $this->penalty;
+                    $buffer[$index] /= $this->penalty;
                 }
             }
         }
@@ -30,7 +30,7 @@ class SuppressTokensAtBeginLogitsProcessor extends LogitsProcessor
             if (count($inputIds[$i]) === $this->beginIndex) {
                 $batchLogits = $logits[$i];
                 foreach ($this->beginSuppressTokens as $token) {
-                    $batchLogits->buffer()[$token] = -INF;
+                    $batchLogits->buffer()[$batchLogits->offset() + $token] = -INF;
                 }
             }
         }
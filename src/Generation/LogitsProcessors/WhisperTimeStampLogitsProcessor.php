@@ -63,52 +63,69 @@ class WhisperTimeStampLogitsProcessor extends LogitsProcessor
      */
     public function __invoke(array $inputIds, Tensor $logits): Tensor
     {
+        for ($i = 0; $i < count($inputIds); $i++) {
+            $this->processBatch($inputIds[$i], $logits[$i]);
+        }
+
+        return $logits;
+    }
+
+    /**
+     * Applies the timestamp rules to the logits of one sequence of the batch, in place.
+     *
+     * @param int[] $seq The tokens generated so far for this sequence.
+     * @param Tensor $logits The `[1, vocab_size]` logits of this sequence.
+     */
+    protected function processBatch(array $seq, Tensor $logits): void
+    {
+        $buffer = $logits->buffer();
+        $offset = $logits->offset();
+        $vocabSize = $logits->size();
+
         // suppress which is handled by without_timestamps
-        $logits->buffer()[$this->noTimestampsTokenId] = -INF;
+        $buffer[$offset + $this->noTimestampsTokenId] = -INF;
 
-        if (count($inputIds) === $this->beginIndex - 1) {
+        if (count($seq) === $this->beginIndex - 1) {
             Tensor::mo()->la()->fill(-INF, $logits);
-            $logits->buffer()[$this->timestampBegin] = 0;
-            return $logits;
+            $buffer[$offset + $this->timestampBegin] = 0;
+            return;
         }
 
         // timestamps have to appear in pairs, except directly before eos_token; mask logits accordingly
-        $seq = array_slice($inputIds, $this->beginIndex);
-        $lastWasTimestamp = count($seq) >= 1 && $seq[count($seq) - 1] >= $this->timestampBegin;
-        $penultimateWasTimestamp = count($seq) < 2 || $seq[count($seq) - 2] >= $this->timestampBegin;
+        $seqs = array_slice($seq, $this->beginIndex);
+        $lastWasTimestamp = count($seqs) >= 1 && $seqs[count($seqs) - 1] >= $this->timestampBegin;
+        $penultimateWasTimestamp = count($seqs) < 2 || $seqs[count($seqs) - 2] >= $this->timestampBegin;
 
         if ($lastWasTimestamp) {
             if ($penultimateWasTimestamp) { // has to be non-timestamp
-                for ($i = $this->timestampBegin; $i < $logits->size(); $i++) {
-                    $logits->buffer()[$i] = -INF;
+                for ($i = $this->timestampBegin; $i < $vocabSize; $i++) {
+                    $buffer[$offset + $i] = -INF;
                 }
             } else { // cannot be normal text tokens
                 for ($i = 0; $i < $this->eosTokenId; $i++) {
-                    $logits->buffer()[$i] = -INF;
+                    $buffer[$offset + $i] = -INF;
                 }
             }
         }
 
         // apply the `max_initial_timestamp` option
-        if (count($inputIds) === $this->beginIndex && $this->maxInitialTimestampIndex !== null) {
+        if (count($seq) === $this->beginIndex && $this->maxInitialTimestampIndex !== null) {
             $lastAllowed = $this->timestampBegin + $this->maxInitialTimestampIndex;
-            for ($i = $lastAllowed + 1; $i < $logits->size(); $i++) {
-                $logits->buffer()[$i] = -INF;
+            for ($i = $lastAllowed + 1; $i < $vocabSize; $i++) {
+                $buffer[$offset + $i] = -INF;
             }
         }
 
         // if sum of probability over timestamps is above any other token, sample timestamp
         $logProbs = $logits->softmax()->log();
-        $timestampProbs = $logProbs->sliceWithBounds([0, $this->timestampBegin], [1, $logProbs->size() - $this->timestampBegin]);
+        $timestampProbs = $logProbs->sliceWithBounds([0, $this->timestampBegin], [1, $vocabSize - $this->timestampBegin]);
         $timestampLogProb = log($timestampProbs->exp()->sum());
         $maxTextTokenLogProb = $logProbs->sliceWithBounds([0, 0], [1, $this->timestampBegin])->max();
 
         if ($timestampLogProb > $maxTextTokenLogProb) {
             for ($i = 0; $i < $this->timestampBegin; $i++) {
-                $logits->buffer()[$i] = -INF;
+                $buffer[$offset + $i] = -INF;
             }
         }
-
-        return $logits;
     }
 }
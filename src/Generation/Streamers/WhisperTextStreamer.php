@@ -14,20 +14,27 @@ use Symfony\Component\Console\Output\OutputInterface;
  * Utility class to handle streaming of tokens generated by whisper speech-to-text models.
  *
  * Callback functions are invoked when each of the following events occur:
- *   - A new chunk starts (onChunkStart)
+ *   - A timestamp starts or ends a segment (onTimestampStart, onTimestampEnd)
  *   - A new token is generated (onStream)
  *   - A chunk ends (onChunkEnd)
  *   - The stream is finalized (onStreamEnd)
+ *
+ * In a streaming recognition session, the current chunk is decoded again as audio arrives: each decode restarts
+ * the chunk, so onStream receives the partial hypotheses, and onChunkEnd the final text once the chunk is done.
  */
 class WhisperTextStreamer extends Streamer
 {
     protected mixed $onTimestampStartCallback = null;
     protected mixed $onTimestampEndCallback = null;
+    protected mixed $onChunkEndCallback = null;
     protected int $timestampBegin;
     protected float $timePrecision = 0.02;
     protected bool $waitingForTimestamp = false;
     protected float $cumulativeOffset = 0.0;
 
+    /** The time, in seconds, at which the audio of the current chunk starts. Added to timestamps. */
+    protected float $chunkOffset = 0.0;
+
     protected array $chunksToProcess = [[
         'tokens' => [],
         'finalized' => false,
@@ -58,7 +65,7 @@ class WhisperTextStreamer extends Streamer
         $offset = end($tokens) - $this->timestampBegin;
 
         if ($offset >= 0) {
-            $time = $offset * $this->timePrecision;
+            $time = $this->chunkOffset + $offset * $this->timePrecision;
             if ($this->waitingForTimestamp) {
                 if ($this->onTimestampEndCallback !== null) {
                     call_user_func($this->onTimestampEndCallback, $time);
@@ -69,7 +76,6 @@ class WhisperTextStreamer extends Streamer
                 }
             }
             $this->waitingForTimestamp = !$this->waitingForTimestamp;
-            $value[0]['output_token_ids'] = [];
         }
 
         $lastChunk = &$this->chunksToProcess[count($this->chunksToProcess) - 1];
@@ -102,6 +108,29 @@ class WhisperTextStreamer extends Streamer
                 'finalized' => false
             ];
         }
+
+        if ($this->onChunkEndCallback !== null) {
+            $finalized = array_filter($this->chunksToProcess, fn($chunk) => $chunk['finalized']);
+            [$text] = $this->tokenizer->decodeASR(array_values($finalized), $this->timePrecision);
+
+            call_user_func($this->onChunkEndCallback, $text);
+        }
+    }
+
+    /**
+     * Discards the tokens streamed so far for the current chunk, before it is decoded again.
+     *
+     * @param float $offset The time, in seconds, at which the audio of the chunk starts.
+     */
+    public function restartChunk(float $offset = 0.0): static
+    {
+        $lastChunk = &$this->chunksToProcess[count($this->chunksToProcess) - 1];
+        $lastChunk['tokens'] = [];
+
+        $this->chunkOffset = $offset;
+        $this->waitingForTimestamp = false;
+
+        return $this;
     }
 
     public function onTimestampStart(callable $callback): static
@@ -116,6 +145,15 @@ class WhisperTextStreamer extends Streamer
         return $this;
     }
 
+    /**
+     * @param callable $callback Called with the text of every finalized chunk so far, each time a chunk ends.
+     */
+    public function onChunkEnd(callable $callback): static
+    {
+        $this->onChunkEndCallback = $callback;
+        return $this;
+    }
+
     public function setTimestampBegin(int $timestampBegin): static
     {
         $this->timestampBegin = $timestampBegin;
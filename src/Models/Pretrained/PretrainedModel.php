@@ -381,6 +381,11 @@ class PretrainedModel
         $allInputIds = $inputIds->toArray();
         $streamer?->put($allInputIds);
 
+        // Rows that finished early keep receiving the padding token until every row is done
+        $finished = array_fill(0, $numInputs, false);
+        $padTokenId = $generationConfig->pad_token_id ?? $generationConfig->eos_token_id;
+        $padTokenId = is_array($padTokenId) ? ($padTokenId[0] ?? null) : $padTokenId;
+
         // 9. Generation loop
         $step = 0;
         while (true) {
@@ -409,6 +414,12 @@ class PretrainedModel
 
             // Loop over each batch
             for ($batchIdx = 0; $batchIdx < $nextTokenScores->shape()[0]; ++$batchIdx) {
+                if ($finished[$batchIdx] && $padTokenId !== null) {
+                    $allInputIds[$batchIdx][] = $padTokenId;
+                    $generatedInputIds[] = [$padTokenId];
+                    continue;
+                }
+
                 $logs = $nextTokenScores[$batchIdx];
 
                 $sampledTokens = $sampler($logs);
@@ -427,7 +438,11 @@ class PretrainedModel
             $streamer?->put($generatedInputIds);
 
             $stop = $stoppingCriteria($generatedInputIds, $scores);
-            if (array_every($stop, fn($x) => $x)) {
+            foreach ($stop as $batchIdx => $isDone) {
+                $finished[$batchIdx] = $finished[$batchIdx] || $isDone;
+            }
+
+            if (array_every($finished, fn($x) => $x)) {
                 break;
             }
 
@@ -4,7 +4,7 @@ declare(strict_types=1);
 
 namespace Codewithkyrian\Transformers\Normalizers;
 
-use Codewithkyrian\Transformers\DataStructures\CharTrie;
+use Codewithkyrian\Transformers\DataStructures\DoubleArray;
 use Generator;
 
 class Precompiled extends Normalizer
@@ -22,14 +22,8 @@ class Precompiled extends Normalizer
     private function parse($precompiled_charsmap)
     {
         $trie_size = unpack('V', substr($precompiled_charsmap, 0, 4))[1];
-        $trie_char_size = $trie_size / 4;
-        $trie_blob = [];
-        $offset = 4;
-        for ($i = 0; $i < $trie_char_size; $i++) {
-            $trie_blob[] = unpack('V', substr($precompiled_charsmap, $offset, 4))[1];
-            $offset += 4;
-        }
-        $this->normalized = substr($precompiled_charsmap, $offset);
+        $trie_blob = $trie_size > 0 ? array_values(unpack('V*', substr($precompiled_charsmap, 4, $trie_size))) : [];
+        $this->normalized = substr($precompiled_charsmap, 4 + $trie_size);
         $this->trie = new DoubleArray($trie_blob);
     }
 
@@ -97,15 +91,9 @@ class Precompiled extends Normalizer
         if (empty($results)) {
             return null;
         }
-        $index = $results[0];
-        $index2 = $index;
-        while ($index2 < mb_strlen($this->normalized)) {
-            if (ord($this->normalized[$index2]) === 0) {
-                break;
-            }
-            $index2++;
-        }
-        return mb_substr($this->normalized, $index, $index2 - $index);
+        $index = reset($results);
+        $end = strpos($this->normalized, "\0", $index);
+        return substr($this->normalized, $index, ($end === false ? strlen($this->normalized) : $end) - $index);
     }
 
     private function replace(&$transformations, $old_part, $new_part): void
@@ -138,54 +126,3 @@ class Precompiled extends Normalizer
         return $result;
     }
 }
-
-class DoubleArray
-{
-
-    public function __construct(protected array $array) {}
-
-    public function commonPrefixSearch($key): array
-    {
-        $node_pos = 0;
-        $results = [];
-
-        $unit = $this->array[$node_pos];
-        $node_pos ^= $this->offset($unit);
-
-        foreach (mb_str_split($key) as $c) {
-            if (ord($c) === 0) {
-                break;
-            }
-            $node_pos ^= ord($c);
-            $unit = $this->array[$node_pos];
-            if ($this->label($unit) !== mb_ord($c)) {
-                return $results;
-            }
-            $node_pos ^= $this->offset($unit);
-            if ($this->hasLeaf($unit)) {
-                $results[] = $this->value($this->array[$node_pos]);
-            }
-        }
-        return $results;
-    }
-
-    private function offset($unit): int
-    {
-        return $unit & ((1 << 22) - 1);
-    }
-
-    private function label($unit): int
-    {
-        return $unit >> 24;
-    }
-
-    private function hasLeaf($unit): int
-    {
-        return ($unit >> 23) & 1;
-    }
-
-    private function value($unit): int
-    {
-        return $unit & ((1 << 31) - 1);
-    }
-}
@@ -53,10 +53,7 @@ class AudioClassificationPipeline extends Pipeline
         $id2label = $this->model->config['id2label'];
         $toReturn = [];
 
-        foreach ($inputs as $input) {
-            $audio = new Audio($input);
-            $audioTensor = $audio->toTensor(samplerate: $sampleRate);
-
+        foreach (Audio::loadBatch($inputs, $sampleRate) as $audioTensor) {
             $processedInputs = ($this->processor)($audioTensor);
             $outputs = ($this->model)($processedInputs);
 
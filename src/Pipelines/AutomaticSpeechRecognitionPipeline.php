@@ -9,7 +9,9 @@ use Codewithkyrian\Transformers\Generation\Streamers\WhisperTextStreamer;
 use Codewithkyrian\Transformers\Tensor\Tensor;
 use Codewithkyrian\Transformers\Utils\Audio;
 use Codewithkyrian\Transformers\Utils\Image;
+use Codewithkyrian\Transformers\Utils\VoiceActivityDetector;
 use Codewithkyrian\Transformers\Transformers;
+use Generator;
 
 use function Codewithkyrian\Transformers\Utils\array_pop_key;
 use function Codewithkyrian\Transformers\Utils\array_keys_to_snake_case;
@@ -97,6 +99,53 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
         };
     }
 
+    /**
+     * Starts a session transcribing audio pushed to it as it is captured, e.g. for live captioning.
+     *
+     * @param float $chunkLengthSecs The length of the window decoded at once, left context included.
+     * @param float|null $strideLengthSecs The left context kept from the previous window. Defaults to `chunkLengthSecs / 6`.
+     * @param float $hopLengthSecs How much new audio triggers a new partial hypothesis.
+     * @param WhisperTextStreamer|null $streamer Receives the tokens and timestamps of each hypothesis (Whisper only).
+     * @param mixed ...$args The generation options, as for `__invoke()`.
+     */
+    public function session(
+        float                $chunkLengthSecs = 10.0,
+        ?float               $strideLengthSecs = null,
+        float                $hopLengthSecs = 1.0,
+        ?WhisperTextStreamer $streamer = null,
+        ...$args
+    ): SpeechRecognitionSession {
+        $strideLengthSecs ??= $chunkLengthSecs / 6;
+
+        $generationConfig = null;
+        $returnTimestamps = $args['returnTimestamps'] ?? false;
+
+        if ($this->model->config->modelType === 'whisper') {
+            if ($returnTimestamps === 'word') {
+                throw new \InvalidArgumentException('Word-level timestamps are not supported in streaming sessions');
+            }
+
+            $language = array_pop_key($args, 'language');
+            $task = array_pop_key($args, 'task');
+
+            $generationConfig = $this->whisperGenerationConfig($args, $language, $task, $returnTimestamps);
+        } elseif ($streamer !== null) {
+            throw new \InvalidArgumentException('`streamer` is only supported for Whisper models');
+        }
+
+        return new SpeechRecognitionSession(
+            $this->model,
+            $this->tokenizer,
+            $this->processor,
+            $generationConfig,
+            $streamer,
+            $chunkLengthSecs,
+            $strideLengthSecs,
+            $hopLengthSecs,
+            $returnTimestamps,
+        );
+    }
+
     private function __invokeWhisper(array|string $inputs, ...$args): array|Tensor|Image
     {
         $returnTimestamps = $args['returnTimestamps'] ?? false;
@@ -111,6 +160,8 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
         $language = array_pop_key($args, 'language');
         $task = array_pop_key($args, 'task');
         $streamer = array_pop_key($args, 'streamer');
+        $batchSize = max(1, (int)(array_pop_key($args, 'batchSize') ?? 8));
+        $vad = array_pop_key($args, 'vad');
 
         if (!is_null($streamer) && !is_a($streamer, WhisperTextStreamer::class)) {
             throw new \InvalidArgumentException('`streamer` must be an instance of `WhisperTextStreamer`');
@@ -119,28 +170,19 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
         if (!is_null($streamer)) {
             $logger = Transformers::getLogger();
             $logger->warning('`streamer` is not supported yet for Whisper');
-        }
-
-        $kwargs = array_keys_to_snake_case($args);
-
-        $generationConfig = new GenerationConfig($kwargs);
 
-        if ($language || $task || $returnTimestamps) {
-            if (isset($args['forcedDecoderIds'])) {
-                throw new \InvalidArgumentException('Cannot specify `forcedDecoderIds` when specifying `language`, `task`, or `returnTimestamps`');
-            }
-
-            if (!method_exists($this->tokenizer, 'getDecoderPromptIds')) {
-                throw new \InvalidArgumentException('Tokenizer not supported for Automatic Speech Recognition');
-            }
-
-            $decoderPromptIds = call_user_func([$this->tokenizer, 'getDecoderPromptIds'], language: $language, task: $task, noTimestamps: !$returnTimestamps);
+            // Streamed tokens must come from one chunk at a time
+            $batchSize = 1;
+        }
 
-            if (count($decoderPromptIds) > 0) {
-                $generationConfig['forced_decoder_ids'] = $decoderPromptIds;
-            }
+        // Token timestamps are extracted from the cross attentions of a single sequence, so word-level
+        // timestamps are generated one chunk at a time
+        if ($returnTimestamps === 'word') {
+            $batchSize = 1;
         }
 
+        $generationConfig = $this->whisperGenerationConfig($args, $language, $task, $returnTimestamps);
+
         $isBatched = is_array($inputs);
         if (!$isBatched) {
             $inputs = [$inputs];
@@ -150,6 +192,13 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
         $hopLength = $this->processor->featureExtractor->config['hop_length'];
         $samplingRate = $this->processor->featureExtractor->config['sampling_rate'];
         $timestampBegin = $this->tokenizer->model->convertTokensToIds(["<|notimestamps|>"])[0] + 1;
+        $eosTokenId = $this->tokenizer->model->convertTokensToIds(["<|endoftext|>"])[0];
+
+        if ($vad === true) {
+            $vad = new VoiceActivityDetector($samplingRate);
+        } elseif ($vad !== null && $vad !== false && !$vad instanceof VoiceActivityDetector) {
+            throw new \InvalidArgumentException('`vad` must be a boolean or an instance of `VoiceActivityDetector`');
+        }
 
         $toReturn = [];
 
@@ -157,77 +206,79 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
             ?->setTimePrecision($timePrecision)
             ?->setTimestampBegin($timestampBegin);
 
+        if ($chunkLengthSecs > 0) {
+            if ($strideLengthSecs === null) {
+                $strideLengthSecs = $chunkLengthSecs / 6;
+            } elseif ($chunkLengthSecs <= $strideLengthSecs) {
+                throw new \InvalidArgumentException('`strideLengthSecs` must be less than `chunkLengthSecs`');
+            }
+        }
+
+        // Whole audio files are decoded up front, in parallel when audio workers are configured
+        if (($chunkLengthSecs <= 0 || $vad) && count($inputs) > 1) {
+            $inputs = Audio::loadBatch($inputs, $samplingRate);
+        }
+
         foreach ($inputs as $input) {
-            $audio = new Audio($input);
-            $audioTensor = $audio->toTensor(samplerate: $samplingRate);
+            $audio = $input instanceof Audio || $input instanceof Tensor ? $input : new Audio($input);
 
             $chunks = [];
+            $batch = [];
 
-            if ($chunkLengthSecs > 0) {
+            // Generate for batches of chunks, running the encoder and decoder over the whole batch at once
+            $generateBatch = function () use (&$chunks, &$batch, $generationConfig, $streamer, $hopLength, $samplingRate, $returnTimestamps, $eosTokenId) {
+                $generationConfig['num_frames'] = (int)floor($chunks[$batch[0]]['stride'][0] / $hopLength);
 
-                if ($strideLengthSecs === null) {
-                    $strideLengthSecs = $chunkLengthSecs / 6;
-                } elseif ($chunkLengthSecs <= $strideLengthSecs) {
-                    throw new \InvalidArgumentException('`strideLengthSecs` must be less than `chunkLengthSecs`');
-                }
+                $inputFeatures = ($this->processor)(array_map(fn($i) => $chunks[$i]['audio'], $batch))['input_features'];
 
-                $window = $chunkLengthSecs * $samplingRate;
-                $stride = $strideLengthSecs * $samplingRate;
-                $jump = (int)floor($window - 2 * $stride);
-                $offset = 0;
+                $data = $this->model->generate($inputFeatures, generationConfig: $generationConfig, streamer: $streamer);
 
-                while ($offset < $audioTensor->size()) {
-                    if ($offset + $window > $audioTensor->size()) {
-                        $window = $audioTensor->size() - $offset;
-                        $jump = $window;
-                    }
+                // TODO: Right now we only get top beam
+                foreach ($batch as $row => $i) {
+                    $chunk = &$chunks[$i];
+                    unset($chunk['audio']);
 
-                    $subAudio = $audioTensor->sliceWithBounds([$offset], [$window]);
-                    $feature = ($this->processor)($subAudio);
+                    $sequences = $returnTimestamps === 'word' ? $data['sequences'] : $data;
+                    $chunk['tokens'] = $this->trimAfterEos($sequences[$row]->toArray(), $eosTokenId);
 
-                    $isFirstChunk = $offset === 0;
-                    $isLastChunk = $offset + $jump >= $audioTensor->size();
+                    if ($returnTimestamps === 'word') {
+                        $tokenTimestamps = $data['token_timestamps'][$row]->round(2)->toArray();
+                        $chunk['token_timestamps'] = array_slice($tokenTimestamps, 0, count($chunk['tokens']));
+                    }
 
-                    $chunks[] = [
-                        'stride' => [
-                            $subAudio->size(),
-                            $isFirstChunk ? 0 : $stride,
-                            $isLastChunk ? 0 : $stride
-                        ],
-                        'input_features' => $feature['input_features'],
-                        'is_last' => $isLastChunk
-                    ];
+                    // convert stride to seconds
+                    $chunk['stride'] = array_map(fn($x) => $x / $samplingRate, $chunk['stride']);
 
-                    $offset += $jump;
+                    $streamer?->putChunk($chunk);
+                    unset($chunk);
                 }
-            } else {
-                $chunks = [
-                    [
-                        'stride' => [$audioTensor->size(), 0, 0],
-                        'input_features' => ($this->processor)($audioTensor)['input_features'],
-                        'is_last' => true
-                    ]
-                ];
-            }
 
-            // Generate for each set of input features
-            foreach ($chunks as &$chunk) {
-                $generationConfig['num_frames'] = (int)floor($chunk['stride'][0] / $hopLength);
+                $batch = [];
+            };
 
-                $data = $this->model->generate($chunk['input_features'], generationConfig: $generationConfig, streamer: $streamer);
+            $audioChunks = $vad
+                ? $this->voicedChunks($audio, $samplingRate, $vad, $chunkLengthSecs)
+                : $this->audioChunks($audio, $samplingRate, $chunkLengthSecs, $strideLengthSecs);
 
-                // TODO: Right now we only get top beam
-                if ($returnTimestamps === 'word') {
-                    $chunk['tokens'] = $data['sequences'][0];
-                    $chunk['token_timestamps'] = $data['token_timestamps'][0]->round(2);
-                } else {
-                    $chunk['tokens'] = $data[0];
+            // Fixed-size chunks are generated while the audio is still being decoded, so only the current window is
+            // in memory
+            foreach ($audioChunks as $chunk) {
+                if (count($batch) === $batchSize) {
+                    $generateBatch();
                 }
 
-                // convert stride to seconds
-                $chunk['stride'] = array_map(fn($x) => $x / $samplingRate, $chunk['stride']);
+                $chunks[] = $chunk;
+                $batch[] = array_key_last($chunks);
+            }
 
-                $streamer?->putChunk($chunk);
+            if (!empty($batch)) {
+                $generateBatch();
+            }
+
+            // Nothing but silence
+            if (empty($chunks)) {
+                $toReturn[] = $returnTimestamps ? ['text' => '', 'chunks' => []] : ['text' => ''];
+                continue;
             }
 
             if (!method_exists($this->tokenizer, 'decodeASR')) {
@@ -248,6 +299,153 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
         return $isBatched ? $toReturn : $toReturn[0];
     }
 
+    /**
+     * Builds the generation config for Whisper, forcing the decoder prompt for the language, task and timestamps.
+     */
+    private function whisperGenerationConfig(array $args, ?string $language, ?string $task, bool|string $returnTimestamps): GenerationConfig
+    {
+        $kwargs = array_keys_to_snake_case($args);
+
+        $generationConfig = new GenerationConfig($kwargs);
+
+        if ($language || $task || $returnTimestamps) {
+            if (isset($args['forcedDecoderIds'])) {
+                throw new \InvalidArgumentException('Cannot specify `forcedDecoderIds` when specifying `language`, `task`, or `returnTimestamps`');
+            }
+
+            if (!method_exists($this->tokenizer, 'getDecoderPromptIds')) {
+                throw new \InvalidArgumentException('Tokenizer not supported for Automatic Speech Recognition');
+            }
+
+            $decoderPromptIds = call_user_func([$this->tokenizer, 'getDecoderPromptIds'], language: $language, task: $task, noTimestamps: !$returnTimestamps);
+
+            if (count($decoderPromptIds) > 0) {
+                $generationConfig['forced_decoder_ids'] = $decoderPromptIds;
+            }
+        }
+
+        return $generationConfig;
+    }
+
+    /**
+     * Splits the audio into overlapping chunks as it is decoded.
+     *
+     * Only the samples from the current chunk onwards are buffered, so memory is bounded by the chunk length
+     * rather than the length of the audio. Without a chunk length, the whole audio is a single chunk.
+     *
+     * @param Audio|Tensor $audio The audio to decode, or its already decoded samples.
+     * @return Generator<array{stride: array, audio: Tensor, is_last: bool}>
+     */
+    private function audioChunks(Audio|Tensor $audio, int $samplingRate, float|int $chunkLengthSecs, float|int|null $strideLengthSecs): Generator
+    {
+        if ($chunkLengthSecs <= 0) {
+            $audioTensor = $audio instanceof Tensor ? $audio : $audio->toTensor(samplerate: $samplingRate);
+
+            yield [
+                'stride' => [$audioTensor->size(), 0, 0],
+                'audio' => $audioTensor,
+                'is_last' => true
+            ];
+
+            return;
+        }
+
+        $window = $chunkLengthSecs * $samplingRate;
+        $stride = $strideLengthSecs * $samplingRate;
+        $jump = (int)floor($window - 2 * $stride);
+
+        // $buffer holds the samples from $offset onwards
+        $buffer = null;
+        $offset = 0;
+
+        $blocks = $audio instanceof Tensor ? [$audio] : $audio->stream($samplingRate);
+
+        foreach ($blocks as $block) {
+            $buffer = $buffer === null ? $block : Tensor::concat([$buffer, $block]);
+
+            // A chunk is only known not to be the last once samples past its end have arrived
+            while ($buffer !== null && $buffer->size() > $window) {
+                yield [
+                    'stride' => [(int)$window, $offset === 0 ? 0 : $stride, $stride],
+                    'audio' => $buffer->sliceWithBounds([0], [(int)$window]),
+                    'is_last' => false
+                ];
+
+                $offset += $jump;
+                $buffer = $buffer->sliceWithBounds([$jump], [$buffer->size() - $jump]);
+            }
+        }
+
+        $remaining = $buffer?->size() ?? 0;
+        $start = 0;
+
+        while ($start < $remaining) {
+            if ($start + $window > $remaining) {
+                $window = $remaining - $start;
+                $jump = $window;
+            }
+
+            $subAudio = $buffer->sliceWithBounds([$start], [(int)$window]);
+
+            $isFirstChunk = $offset + $start === 0;
+            $isLastChunk = $start + $jump >= $remaining;
+
+            yield [
+                'stride' => [
+                    $subAudio->size(),
+                    $isFirstChunk ? 0 : $stride,
+                    $isLastChunk ? 0 : $stride
+                ],
+                'audio' => $subAudio,
+                'is_last' => $isLastChunk
+            ];
+
+            $start += $jump;
+        }
+    }
+
+    /**
+     * Splits the audio into its voiced segments, each at most `chunkLengthSecs` (or 30 seconds) long.
+     *
+     * Silence between the segments is never sent to the model. Each chunk carries the time its audio starts at, so
+     * timestamps stay relative to the whole audio.
+     *
+     * @return Generator<array{stride: array, audio: Tensor, is_last: bool, offset: float}>
+     */
+    private function voicedChunks(Audio|Tensor $audio, int $samplingRate, VoiceActivityDetector $vad, float|int $chunkLengthSecs): Generator
+    {
+        $audioTensor = $audio instanceof Tensor ? $audio : $audio->toTensor(samplerate: $samplingRate);
+
+        $maxLengthSecs = $this->processor->featureExtractor->config['chunk_length'];
+        if ($chunkLengthSecs > 0) {
+            $maxLengthSecs = min($chunkLengthSecs, $maxLengthSecs);
+        }
+
+        $segments = $vad->segments($audioTensor, (int)($maxLengthSecs * $samplingRate));
+
+        foreach ($segments as $i => [$start, $end]) {
+            yield [
+                'stride' => [$end - $start, 0, 0],
+                'audio' => $audioTensor->sliceWithBounds([$start], [$end - $start]),
+                'is_last' => $i === count($segments) - 1,
+                'offset' => $start / $samplingRate,
+            ];
+        }
+    }
+
+    /**
+     * Drops the padding a finished sequence received while the rest of its batch was still generating.
+     *
+     * @param int[] $tokens
+     * @return int[]
+     */
+    private function trimAfterEos(array $tokens, int $eosTokenId): array
+    {
+        $eosIndex = array_search($eosTokenId, $tokens, true);
+
+        return $eosIndex === false ? $tokens : array_slice($tokens, 0, $eosIndex + 1);
+    }
+
     private function __invokeWav2Vec2(array|string $inputs, ...$args): array|Tensor|Image
     {
         $isBatched = is_array($inputs);
@@ -260,9 +458,15 @@ class AutomaticSpeechRecognitionPipeline extends Pipeline
 
         $toReturn = [];
         foreach ($inputs as $input) {
-            $audio = new Audio($input);
-            $audioTensor = $audio->toTensor(samplerate: $samplingRate);
-            $processedInputs = ($this->processor)($audioTensor);
+            $audio = $input instanceof Audio ? $input : new Audio($input);
+            $featureExtractor = $this->processor->featureExtractor;
+
+            if (method_exists($featureExtractor, 'extractStream')) {
+                $processedInputs = $featureExtractor->extractStream($audio->stream($samplingRate));
+            } else {
+                $processedInputs = ($this->processor)($audio->toTensor(samplerate: $samplingRate));
+            }
+
             $outputs = ($this->model)($processedInputs);
 
             $logits = $outputs['logits'][0];
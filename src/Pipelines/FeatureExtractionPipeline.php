@@ -91,7 +91,8 @@ class FeatureExtractionPipeline extends Pipeline
 
             case 'last_token':
             case 'eos':
-                $result = $result->slice(null, -1);
+                // Keeps the [batchSize, 1, embedDim] shape of the slice-based pooling, but skips right padding.
+                $result = $result->lastTokenPooling($modelInputs["attention_mask"])->unsqueeze(1);
                 break;
 
             default:
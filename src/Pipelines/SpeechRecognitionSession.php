@@ -0,0 +1,283 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Codewithkyrian\Transformers\Pipelines;
+
+use Codewithkyrian\Transformers\Configs\GenerationConfig;
+use Codewithkyrian\Transformers\Generation\Streamers\WhisperTextStreamer;
+use Codewithkyrian\Transformers\Models\Pretrained\PretrainedModel;
+use Codewithkyrian\Transformers\PreTrainedTokenizers\PreTrainedTokenizer;
+use Codewithkyrian\Transformers\Processors\Processor;
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use InvalidArgumentException;
+
+/**
+ * Transcribes audio pushed to it as it is captured, e.g. for live captioning.
+ *
+ * The audio is cut into segments of `chunkLengthSecs - strideLengthSecs` seconds. Every `hopLengthSecs` seconds of new
+ * audio, the unfinished segment is decoded together with `strideLengthSecs` seconds of left context into a partial
+ * hypothesis. Once a segment is complete, it is decoded one last time into a final hypothesis and never decoded
+ * again, so each decode only covers the tail of the audio and the latency is bounded by the hop length.
+ *
+ * - For Whisper, finalized segments are kept as token sequences, merged by the tokenizer like the chunks of a long
+ *   audio. Partial and final hypotheses are also streamed through the `WhisperTextStreamer`, if one is given.
+ * - For CTC models (Wav2Vec2 and the like), the predicted tokens of the frames of finalized segments are cached,
+ *   and only the frames after the left context of a window are added to them.
+ *
+ * ```php
+ * $session = $transcriber->session(hopLengthSecs: 0.5);
+ *
+ * foreach ($microphone as $samples) {
+ *     $hypothesis = $session->push($samples);
+ *     // [ text: "And so my fellow", is_final: false ]
+ * }
+ *
+ * $output = $session->finish();
+ * ```
+ */
+class SpeechRecognitionSession
+{
+    protected bool $isWhisper;
+
+    protected int $samplingRate;
+
+    protected int $segmentLength;
+
+    protected int $contextLength;
+
+    protected int $hopLength;
+
+    /** The samples from `$bufferStart` onwards. */
+    protected ?Tensor $buffer = null;
+
+    protected int $bufferStart = 0;
+
+    /** The number of samples pushed so far. */
+    protected int $received = 0;
+
+    /** The first sample of the segment that is not final yet. */
+    protected int $segmentStart = 0;
+
+    /** The number of samples pushed when the last hypothesis was decoded. */
+    protected int $lastDecoded = 0;
+
+    /** @var array[] The finalized Whisper chunks. */
+    protected array $chunks = [];
+
+    /** @var int[] The predicted token of every frame of the finalized CTC segments. */
+    protected array $frameIds = [];
+
+    protected float $timePrecision = 0.02;
+
+    protected bool $finished = false;
+
+    public function __construct(
+        protected PretrainedModel      $model,
+        protected PreTrainedTokenizer  $tokenizer,
+        protected Processor            $processor,
+        protected ?GenerationConfig    $generationConfig,
+        protected ?WhisperTextStreamer $streamer,
+        float                          $chunkLengthSecs,
+        float                          $strideLengthSecs,
+        float                          $hopLengthSecs,
+        protected bool|string          $returnTimestamps = false,
+    ) {
+        if ($strideLengthSecs < 0 || $chunkLengthSecs <= $strideLengthSecs) {
+            throw new InvalidArgumentException('`strideLengthSecs` must be less than `chunkLengthSecs`');
+        }
+
+        if ($hopLengthSecs <= 0) {
+            throw new InvalidArgumentException('`hopLengthSecs` must be greater than zero');
+        }
+
+        $config = $this->processor->featureExtractor->config;
+
+        $this->isWhisper = $this->generationConfig !== null;
+        $this->samplingRate = $config['sampling_rate'];
+        $this->segmentLength = (int)round(($chunkLengthSecs - $strideLengthSecs) * $this->samplingRate);
+        $this->contextLength = (int)round($strideLengthSecs * $this->samplingRate);
+        $this->hopLength = max(1, (int)round($hopLengthSecs * $this->samplingRate));
+
+        if ($this->isWhisper) {
+            if ($chunkLengthSecs > $config['chunk_length']) {
+                throw new InvalidArgumentException("`chunkLengthSecs` may not be longer than the {$config['chunk_length']}s Whisper decodes at once");
+            }
+
+            $this->timePrecision = $config['chunk_length'] / $this->model->config['max_source_positions'];
+            $timestampBegin = $this->tokenizer->model->convertTokensToIds(["<|notimestamps|>"])[0] + 1;
+
+            $this->streamer?->setTokenizer($this->tokenizer)
+                ?->setTimePrecision($this->timePrecision)
+                ?->setTimestampBegin($timestampBegin);
+        }
+    }
+
+    /**
+     * Adds captured audio to the session.
+     *
+     * @param Tensor|float[] $samples Mono samples at the sampling rate of the model.
+     *
+     * @return array|null The hypothesis for all the audio so far, as `[text, is_final]`, if this audio completed
+     *  a segment or a hop. Null otherwise.
+     */
+    public function push(Tensor|array $samples): ?array
+    {
+        if ($this->finished) {
+            throw new InvalidArgumentException('Cannot push audio to a finished session');
+        }
+
+        $samples = $samples instanceof Tensor ? $samples : Tensor::fromArray($samples, Tensor::float32);
+
+        if ($samples->size() === 0) {
+            return null;
+        }
+
+        $this->buffer = $this->buffer === null ? $samples : Tensor::concat([$this->buffer, $samples]);
+        $this->received += $samples->size();
+
+        $hypothesis = null;
+
+        while ($this->received >= $this->segmentStart + $this->segmentLength) {
+            $hypothesis = $this->decode($this->segmentStart + $this->segmentLength, true, false);
+        }
+
+        if ($hypothesis === null && $this->received - $this->lastDecoded >= $this->hopLength) {
+            $hypothesis = $this->decode($this->received, false, false);
+        }
+
+        return $hypothesis;
+    }
+
+    /**
+     * Decodes the remaining audio and ends the session.
+     *
+     * @return array The transcription of the whole session, like the pipeline returns it.
+     */
+    public function finish(): array
+    {
+        if (!$this->finished) {
+            if ($this->received > $this->segmentStart || empty($this->chunks)) {
+                $this->decode($this->received, true, true);
+            } elseif ($this->isWhisper) {
+                $this->chunks[count($this->chunks) - 1]['is_last'] = true;
+            }
+
+            $this->finished = true;
+            $this->buffer = null;
+        }
+
+        if (!$this->isWhisper) {
+            return ['text' => $this->tokenizer->decode($this->frameIds)];
+        }
+
+        [$text, $optional] = $this->tokenizer->decodeASR(
+            $this->chunks,
+            timePrecision: $this->timePrecision,
+            returnTimestamps: $this->returnTimestamps,
+            forceFullSequences: false
+        );
+
+        return ['text' => $text, ...$optional];
+    }
+
+    /**
+     * Decodes the unfinished segment up to `$end`, with its left context.
+     *
+     * @return array The hypothesis for all the audio so far.
+     */
+    protected function decode(int $end, bool $final, bool $isLast): array
+    {
+        $start = max(0, $this->segmentStart - $this->contextLength);
+
+        $window = $end > $start
+            ? $this->buffer->sliceWithBounds([$start - $this->bufferStart], [$end - $start])
+            : Tensor::zeros([$this->hopLength], Tensor::float32);
+
+        $text = $this->isWhisper
+            ? $this->decodeWhisper($window, $start, $final, $isLast)
+            : $this->decodeCTC($window, $start, $final);
+
+        if ($final) {
+            $this->segmentStart = $end;
+
+            // Only the left context of the next segment is needed from now on
+            $keepFrom = max(0, $this->segmentStart - $this->contextLength);
+
+            if ($keepFrom > $this->bufferStart && $this->buffer !== null) {
+                $this->buffer = $this->received > $keepFrom
+                    ? $this->buffer->sliceWithBounds([$keepFrom - $this->bufferStart], [$this->received - $keepFrom])
+                    : null;
+                $this->bufferStart = $keepFrom;
+            }
+        }
+
+        $this->lastDecoded = $this->received;
+
+        return ['text' => $text, 'is_final' => $final];
+    }
+
+    protected function decodeWhisper(Tensor $window, int $start, bool $final, bool $isLast): string
+    {
+        $this->streamer?->restartChunk($start / $this->samplingRate);
+
+        $hopLength = $this->processor->featureExtractor->config['hop_length'];
+        $this->generationConfig['num_frames'] = (int)floor($window->size() / $hopLength);
+
+        $inputFeatures = ($this->processor)($window)['input_features'];
+
+        $sequences = $this->model->generate($inputFeatures, generationConfig: $this->generationConfig, streamer: $this->streamer);
+
+        $chunk = [
+            'tokens' => $sequences[0]->toArray(),
+            'stride' => [
+                $window->size() / $this->samplingRate,
+                ($this->segmentStart - $start) / $this->samplingRate,
+                0
+            ],
+            'is_last' => $isLast,
+        ];
+
+        if ($final) {
+            $this->chunks[] = $chunk;
+            $this->streamer?->putChunk($chunk);
+
+            $chunks = $this->chunks;
+        } else {
+            $chunks = [...$this->chunks, $chunk];
+        }
+
+        [$text] = $this->tokenizer->decodeASR($chunks, $this->timePrecision, forceFullSequences: false);
+
+        return $text;
+    }
+
+    protected function decodeCTC(Tensor $window, int $start, bool $final): string
+    {
+        $featureExtractor = $this->processor->featureExtractor;
+
+        $inputs = method_exists($featureExtractor, 'extractStream')
+            ? $featureExtractor->extractStream([$window])
+            : ($this->processor)($window);
+
+        $logits = ($this->model)($inputs)['logits'][0];
+
+        $predictedIds = [];
+        foreach ($logits as $item) {
+            $predictedIds[] = $item->argMax();
+        }
+
+        // Drop the frames of the left context, whose tokens were cached with the previous segment
+        $samplesPerFrame = $window->size() / max(1, count($predictedIds));
+        $contextFrames = (int)round(($this->segmentStart - $start) / $samplesPerFrame);
+        $newIds = array_slice($predictedIds, $contextFrames);
+
+        if ($final) {
+            array_push($this->frameIds, ...$newIds);
+
+            return $this->tokenizer->decode($this->frameIds);
+        }
+
+        return $this->tokenizer->decode([...$this->frameIds, ...$newIds]);
+    }
+}
@@ -94,6 +94,12 @@ class AutoTokenizer
         mixed     $legacy = null,
         ?callable $onProgress = null
     ): ?PreTrainedTokenizer {
+        $snapshot = TokenizerSnapshot::forModel($modelNameOrPath, $cacheDir, $revision, $legacy, $onProgress);
+
+        if ($snapshot !== null && ($tokenizer = $snapshot->load()) !== null) {
+            return $tokenizer;
+        }
+
         ['tokenizerJson' => $tokenizerJson, 'tokenizerConfig' => $tokenizerConfig] =
             TokenizerModel::load($modelNameOrPath, $cacheDir, $revision, $legacy, $onProgress);
 
@@ -112,6 +118,10 @@ class AutoTokenizer
             $cls = PreTrainedTokenizer::class;
         }
 
-        return new $cls($tokenizerJson, $tokenizerConfig);
+        $tokenizer = new $cls($tokenizerJson, $tokenizerConfig);
+
+        $snapshot?->save($tokenizer);
+
+        return $tokenizer;
     }
 }
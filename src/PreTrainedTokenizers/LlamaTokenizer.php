@@ -61,7 +61,7 @@ class LlamaTokenizer extends PreTrainedTokenizer
 
         $tokens = parent::encodeText(self::SPIECE_UNDERLINE . str_replace(self::SPIECE_UNDERLINE, ' ', $text));
 
-        if (count($tokens) > 1 && $tokens[0] === self::SPIECE_UNDERLINE && in_array($tokens[1], $this->specialTokens)) {
+        if (count($tokens) > 1 && $tokens[0] === self::SPIECE_UNDERLINE && isset($this->specialTokenSet[$tokens[1]])) {
             $tokens = array_slice($tokens, 1);
         }
 
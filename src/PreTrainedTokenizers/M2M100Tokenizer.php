@@ -13,7 +13,6 @@ class M2M100Tokenizer extends PreTrainedTokenizer
     protected string $languageRegex = '/^__[a-z]{2,3}__$/';
 
     protected array $languageCodes = [];
-    protected \Closure $langToToken;
 
     public function __construct(array $tokenizerJSON, array $tokenizerConfig)
     {
@@ -24,9 +23,14 @@ class M2M100Tokenizer extends PreTrainedTokenizer
             fn($token) => substr($token, 2, -2), // Extract language code from token
             array_filter($this->specialTokens, fn($x) => preg_match($this->languageRegex, $x))
         );
+    }
 
-
-        $this->langToToken = fn($x) => "__{$x}__";
+    /**
+     * Maps a language code to its special token.
+     */
+    protected function langToToken(string $x): string
+    {
+        return "__{$x}__";
     }
 
 
@@ -72,7 +76,7 @@ class M2M100Tokenizer extends PreTrainedTokenizer
             // to force the source language to be first:
             foreach ($this->postProcessor->config['single'] as &$item) {
                 if (isset($item['SpecialToken']) && preg_match($this->languageRegex, $item['SpecialToken']['id'])) {
-                    $item['SpecialToken']['id'] = call_user_func($this->langToToken, $srcLangToken);
+                    $item['SpecialToken']['id'] = $this->langToToken($srcLangToken);
                     break;
                 }
             }
@@ -81,7 +85,7 @@ class M2M100Tokenizer extends PreTrainedTokenizer
 
         // Override the `forced_bos_token_id` to force the correct language
         $generationConfig->forced_bos_token_id = $this->model->convertTokensToIds(
-            [call_user_func($this->langToToken, $tgtLangToken)]
+            [$this->langToToken($tgtLangToken)]
         )[0];
 
         return $this->__invoke($rawInputs, padding: $padding, addSpecialTokens: $addSpecialTokens, truncation: $truncation, maxLength: $maxLength);
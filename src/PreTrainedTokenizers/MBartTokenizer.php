@@ -11,7 +11,6 @@ class MBartTokenizer extends PreTrainedTokenizer
 {
     protected string $languageRegex = '/^[a-z]{2}_[A-Z]{2}$/';
     protected array $languageCodes = [];
-    protected \Closure $langToToken;
 
     public function __construct(array $tokenizerJSON, array $tokenizerConfig)
     {
@@ -20,8 +19,14 @@ class MBartTokenizer extends PreTrainedTokenizer
         $this->languageCodes = array_filter($this->specialTokens, function ($x) {
             return preg_match($this->languageRegex, $x);
         });
+    }
 
-        $this->langToToken = fn($x) => $x;  // Identity function
+    /**
+     * Maps a language code to its special token.
+     */
+    protected function langToToken(string $x): string
+    {
+        return $x;
     }
 
 
@@ -67,7 +72,7 @@ class MBartTokenizer extends PreTrainedTokenizer
             // to force the source language to be first:
             foreach ($this->postProcessor->config['single'] as &$item) {
                 if (isset($item['SpecialToken']) && preg_match($this->languageRegex, $item['SpecialToken']['id'])) {
-                    $item['SpecialToken']['id'] = call_user_func($this->langToToken, $srcLangToken);
+                    $item['SpecialToken']['id'] = $this->langToToken($srcLangToken);
                     break;
                 }
             }
@@ -76,7 +81,7 @@ class MBartTokenizer extends PreTrainedTokenizer
 
         // Override the `forced_bos_token_id` to force the correct language
         $generationConfig->forced_bos_token_id = $this->model->convertTokensToIds(
-            [call_user_func($this->langToToken, $tgtLangToken)]
+            [$this->langToToken($tgtLangToken)]
         )[0];
 
         return $this->__invoke($rawInputs, padding: $padding, addSpecialTokens: $addSpecialTokens, truncation: $truncation, maxLength: $maxLength);
@@ -7,6 +7,7 @@ namespace Codewithkyrian\Transformers\PreTrainedTokenizers;
 
 use Closure;
 use Codewithkyrian\Jinja\Template;
+use Codewithkyrian\Transformers\Decoders\ByteLevelDecoder;
 use Codewithkyrian\Transformers\Decoders\Decoder;
 use Codewithkyrian\Transformers\Normalizers\Normalizer;
 use Codewithkyrian\Transformers\PostProcessors\PostProcessedOutput;
@@ -14,15 +15,30 @@ use Codewithkyrian\Transformers\PostProcessors\PostProcessor;
 use Codewithkyrian\Transformers\PreTokenizers\PreTokenizer;
 use Codewithkyrian\Transformers\Tensor\Tensor;
 use Codewithkyrian\Transformers\Tokenizers\AddedToken;
+use Codewithkyrian\Transformers\Tokenizers\AddedTokenMatcher;
 use Codewithkyrian\Transformers\Tokenizers\TokenizerModel;
 use Error;
 use Exception;
+use function Codewithkyrian\Transformers\Utils\forkMap;
 use function Codewithkyrian\Transformers\Utils\timeUsage;
 use Codewithkyrian\Transformers\Transformers;
 use Psr\Log\LoggerInterface;
 
 class PreTrainedTokenizer
 {
+    /**
+     * The smallest share of a batch worth handing to a forked tokenizer worker.
+     */
+    protected const MIN_TEXTS_PER_WORKER = 64;
+
+    /**
+     * How many characters past the previous token to look for the next one when aligning offsets.
+     */
+    protected const OFFSET_SEARCH_WINDOW = 256;
+
+    /** @var array<string, string[]> Folded form of each character seen while aligning offsets. */
+    protected static array $alignmentFolds = [];
+
     public ?TokenizerModel $model;
     public ?string $maskToken = null;
     public ?int $maskTokenId = null;
@@ -41,7 +57,11 @@ class PreTrainedTokenizer
      */
     protected array $addedTokens = [];
     protected array $additionalSpecialTokens = [];
-    protected string $addedTokensRegex = '';
+    protected AddedTokenMatcher $addedTokensMatcher;
+    protected ?AddedTokenMatcher $normalizedAddedTokensMatcher = null;
+    protected array $specialTokenSet = [];
+    protected array $specialIdSet = [];
+    protected ?array $addedTokenContents = null;
     protected ?string $padToken = null;
     protected ?int $padTokenId = null;
     protected ?string $sepToken = null;
@@ -101,20 +121,34 @@ class PreTrainedTokenizer
         $this->specialTokens = [...$this->specialTokens, ...$this->additionalSpecialTokens];
         $this->specialTokens = array_unique($this->specialTokens);
 
+        $this->specialTokenSet = array_fill_keys($this->specialTokens, true);
+        $this->specialIdSet = array_fill_keys($this->allSpecialIds, true);
+
         if ($this->decoder != null) {
             // Slight hack, but it prevents code duplication:
             $this->decoder->addedTokens = $this->addedTokens;
             $this->decoder->endOfWordSuffix = $this->model->endOfWordSuffix;
         }
 
-        if (count($this->addedTokens) > 0) {
-            $addedTokensPatterns = array_map(function ($x) {
-                $lstrip = $x->lStrip ? '\s*' : '';
-                $rstrip = $x->rStrip ? '\s*' : '';
-                return $lstrip . '(' . preg_quote($x->content, '/') . ')' . $rstrip;
-            }, $this->addedTokens);
+        // Like the Hugging Face tokenizers, tokens flagged as normalized are matched against the normalized text
+        $rawTokens = [];
+        $normalizedTokens = [];
+
+        foreach ($this->addedTokens as $token) {
+            if ($token->normalized && $this->normalizer !== null) {
+                $normalizedTokens[] = $token;
+            } else {
+                $rawTokens[] = $token;
+            }
+        }
+
+        $this->addedTokensMatcher = new AddedTokenMatcher($rawTokens);
 
-            $this->addedTokensRegex = '/' . implode('|', $addedTokensPatterns) . '/';
+        if (!empty($normalizedTokens)) {
+            $this->normalizedAddedTokensMatcher = new AddedTokenMatcher(
+                $normalizedTokens,
+                fn(string $content) => $this->normalizer->normalize($content)
+            );
         }
 
         // Set mask token if present
@@ -146,6 +180,32 @@ class PreTrainedTokenizer
         $this->chatTemplate = $tokenizerConfig['chat_template'] ?? null;
     }
 
+    /**
+     * Returns the fully-built tokenizer state for a snapshot. The raw tokenizer JSON is only needed while
+     * constructing, and the logger and compiled chat templates are rebuilt when the snapshot is restored.
+     */
+    public function __serialize(): array
+    {
+        $state = get_object_vars($this);
+
+        unset($state['logger'], $state['tokenizerJSON'], $state['compiledTemplateCache']);
+
+        return $state;
+    }
+
+    /**
+     * Restores a tokenizer from a snapshot without re-running the constructor.
+     */
+    public function __unserialize(array $data): void
+    {
+        foreach ($data as $property => $value) {
+            $this->{$property} = $value;
+        }
+
+        $this->tokenizerJSON = [];
+        $this->logger = Transformers::getLogger();
+    }
+
     /**
      * Returns the value of the first matching key in the tokenizer config array.
      *
@@ -209,8 +269,10 @@ class PreTrainedTokenizer
      * @param bool $addSpecialTokens Whether to add the special tokens associated with the corresponding model.
      * @param bool $truncation Whether to truncate the input sequences.
      * @param int|null $maxLength Maximum length of the returned list and optionally padding length.
+     * @param bool|string $returnOffsetsMapping Whether to return the span of the text each token covers, in
+     *  characters, or in bytes if set to 'bytes'.
      *
-     * @return array{input_ids: Tensor, attention_mask: Tensor, token_type_ids: Tensor|null}
+     * @return array{input_ids: Tensor, attention_mask: Tensor, token_type_ids: Tensor|null, offset_mapping?: Tensor}
      */
     public function tokenize(
         string|array      $text,
@@ -219,9 +281,10 @@ class PreTrainedTokenizer
         bool              $addSpecialTokens = true,
         bool              $truncation = false,
         ?int              $maxLength = null,
-        bool              $returnTensor = true
+        bool              $returnTensor = true,
+        bool|string       $returnOffsetsMapping = false
     ): array {
-        return $this->__invoke($text, $textPair, $padding, $addSpecialTokens, $truncation, $maxLength, $returnTensor);
+        return $this->__invoke($text, $textPair, $padding, $addSpecialTokens, $truncation, $maxLength, $returnTensor, $returnOffsetsMapping);
     }
 
     /**
@@ -234,8 +297,11 @@ class PreTrainedTokenizer
      * @param bool $truncation Whether to truncate the input sequences.
      * @param int|null $maxLength Maximum length of the returned list and optionally padding length.
      * @param bool $returnTensor Whether to return the result as a Tensor. If false, the result will be an array.
+     * @param bool|string $returnOffsetsMapping Whether to return the span of the text each token covers, as
+     *  [start, end) pairs in characters, or in bytes if set to 'bytes'. Special tokens added by the
+     *  post-processor get [0, 0]. As a tensor, the offsets are int32 with shape [batch, seq, 2].
      *
-     * @return array{input_ids: Tensor|array, attention_mask: Tensor|array, token_type_ids: Tensor|array|null}
+     * @return array{input_ids: Tensor|array, attention_mask: Tensor|array, token_type_ids: Tensor|array|null, offset_mapping?: Tensor|array}
      */
     public function __invoke(
         string|array      $text,
@@ -244,9 +310,15 @@ class PreTrainedTokenizer
         bool              $addSpecialTokens = true,
         bool              $truncation = false,
         ?int              $maxLength = null,
-        bool              $returnTensor = true
+        bool              $returnTensor = true,
+        bool|string       $returnOffsetsMapping = false
     ): array {
         $isBatched = is_array($text);
+        $offsetUnit = match ($returnOffsetsMapping) {
+            false => null,
+            'bytes' => 'bytes',
+            default => 'chars',
+        };
 
         $encodedTokens = [];
 
@@ -265,16 +337,14 @@ class PreTrainedTokenizer
                     throw new Exception('$text and $textPair must have the same length');
                 }
 
-                $encodedTokens = array_map(
-                    fn($t, $i) => $this->encodePlus($t, $textPair[$i], $addSpecialTokens),
-                    $text,
-                    array_keys($text)
+                $encodedTokens = $this->encodeBatch(
+                    array_values($text),
+                    array_map(fn($i) => $textPair[$i], array_keys($text)),
+                    $addSpecialTokens,
+                    $offsetUnit
                 );
             } else {
-                $encodedTokens = array_map(
-                    fn($x) => $this->encodePlus($x, addSpecialTokens: $addSpecialTokens),
-                    $text
-                );
+                $encodedTokens = $this->encodeBatch(array_values($text), null, $addSpecialTokens, $offsetUnit);
             }
         } else {
             if (is_array($textPair)) {
@@ -283,7 +353,7 @@ class PreTrainedTokenizer
             }
 
             // For single input, we just wrap in an array, and then unwrap later.
-            $encodedTokens = [$this->encodePlus($text, $textPair, $addSpecialTokens)];
+            $encodedTokens = [$this->encodePlus($text, $textPair, $addSpecialTokens, $offsetUnit)];
         }
 
         // At this point, tokens is batched: [batch_size, tokens]
@@ -306,67 +376,38 @@ class PreTrainedTokenizer
         $maxLength = min($maxLength, $this->modelMaxLength);
 
 
-        if ($padding || $truncation) {
-            for ($i = 0; $i < count($encodedTokens); $i++) {
-                $token = &$encodedTokens[$i];
-                if (count($token['input_ids']) === $maxLength) {
-                    continue;
-                } elseif (count($token['input_ids']) > $maxLength) {
-                    // possibly truncate
-                    if ($truncation) {
-                        $this->truncateHelper($token, $maxLength);
-                    }
-                } else {
-                    // t.length < max_length
-                    // possibly pad
-                    if ($padding) {
-                        $this->padHelper(
-                            $token,
-                            $maxLength,
-                            fn($key) => $key === 'input_ids' ? $this->padTokenId : 0,
-                            $this->paddingSide
-                        );
-                    }
+        if ($truncation) {
+            foreach ($encodedTokens as &$token) {
+                if (count($token['input_ids']) > $maxLength) {
+                    $this->truncateHelper($token, $maxLength);
                 }
-                // Update the encodedTokens array with the modified token
-                //    $encodedTokens[$i] = $token;
             }
+            unset($token);
         }
 
         if ($returnTensor) {
-            if (!($padding && $truncation)) {
-                // Not guaranteed that all items have the same length, so we perform additional check
-                if (
-                    array_reduce($encodedTokens, function ($carry, $x) use ($encodedTokens) {
-                        foreach ($x as $key => $value) {
-                            if (count($value ?? []) !== count($encodedTokens[0][$key] ?? [])) {
-                                return true;
-                            }
-                        }
-                        return $carry;
-                    }, false)
-                ) {
-                    throw new Error("Unable to create tensor, you should probably activate truncation and/or padding with 'padding=true' and 'truncation=true' to have batched tensors with the same length.");
-                }
-            }
-
-            // Now we actually convert to Tensor
             // NOTE: In the same way as the python library, we return a batched tensor, regardless of whether
             // we have a single input or multiple inputs.
-            $shape = [count($encodedTokens), count($encodedTokens[0]['input_ids'])];
-            $result = [];
-
-
-            foreach ($encodedTokens[0] as $key => $value) {
-                if ($value === null) {
-                    continue;
+            $result = $this->packBatch($encodedTokens, $padding ? ($maxLength ?? 0) : 0);
+        } else {
+            if ($padding) {
+                foreach ($encodedTokens as &$token) {
+                    if (count($token['input_ids']) < $maxLength) {
+                        $this->padHelper(
+                            $token,
+                            $maxLength,
+                            fn($key) => match ($key) {
+                                'input_ids' => $this->padTokenId,
+                                'offset_mapping' => [0, 0],
+                                default => 0,
+                            },
+                            $this->paddingSide
+                        );
+                    }
                 }
-
-                $array = array_map(fn($x) => $x[$key], $encodedTokens);
-
-                $result[$key] = new Tensor($array, Tensor::int64, $shape);
+                unset($token);
             }
-        } else {
+
             $result = [];
 
             foreach ($encodedTokens[0] as $key => $value) {
@@ -384,19 +425,104 @@ class PreTrainedTokenizer
         return $result;
     }
 
+    /**
+     * Encodes a batch of texts. When tokenizer workers are configured and the batch is large enough to
+     * amortize the fork, the batch is split across forked worker processes that send their encodings back
+     * over a socket pair.
+     *
+     * @param string[] $texts The texts to encode.
+     * @param string[]|null $textPairs The optional second sequences, aligned with `$texts`.
+     * @param bool $addSpecialTokens Whether to add the special tokens associated with the corresponding model.
+     * @param string|null $offsetUnit Whether to compute offsets, in 'chars' or 'bytes'.
+     *
+     * @return array<array{input_ids: int[], attention_mask: int[], token_type_ids: int[]|null}>
+     */
+    protected function encodeBatch(array $texts, ?array $textPairs, bool $addSpecialTokens, ?string $offsetUnit = null): array
+    {
+        $workers = min(Transformers::getTokenizerWorkers(), intdiv(count($texts), self::MIN_TEXTS_PER_WORKER));
+
+        return forkMap(
+            $texts,
+            $workers,
+            fn(array $chunk, int $start) => $this->encodeRange($texts, $textPairs, $addSpecialTokens, $offsetUnit, $start, $start + count($chunk))
+        );
+    }
+
+    /**
+     * Encodes the texts of a batch from `$start` up to (but not including) `$end`.
+     */
+    protected function encodeRange(array $texts, ?array $textPairs, bool $addSpecialTokens, ?string $offsetUnit, int $start, int $end): array
+    {
+        $encodedTokens = [];
+
+        for ($i = $start; $i < $end; $i++) {
+            $encodedTokens[] = $this->encodePlus($texts[$i], $textPairs[$i] ?? null, $addSpecialTokens, $offsetUnit);
+        }
+
+        return $encodedTokens;
+    }
+
+    /**
+     * Packs the encoded sequences of a batch straight into contiguous int64 tensors of shape [batch, length],
+     * padding the rows shorter than `$padTo` on the padding side while packing.
+     *
+     * @throws Error If the rows do not all end up with the same length.
+     */
+    protected function packBatch(array $encodedTokens, int $padTo): array
+    {
+        $length = max(count($encodedTokens[0]['input_ids']), $padTo);
+
+        foreach ($encodedTokens as $token) {
+            if (max(count($token['input_ids']), $padTo) !== $length) {
+                throw new Error("Unable to create tensor, you should probably activate truncation and/or padding with 'padding=true' and 'truncation=true' to have batched tensors with the same length.");
+            }
+        }
+
+        $shape = [count($encodedTokens), $length];
+        $result = [];
+
+        foreach ($encodedTokens[0] as $key => $value) {
+            if ($value === null) {
+                continue;
+            }
+
+            // Offsets are [start, end) pairs, packed as an extra trailing dimension
+            $isOffsets = $key === 'offset_mapping';
+            $padValue = $isOffsets
+                ? pack('l2', 0, 0)
+                : pack('q', $key === 'input_ids' ? ($this->padTokenId ?? 0) : 0);
+            $bytes = '';
+
+            foreach ($encodedTokens as $token) {
+                $packed = $isOffsets ? pack('l*', ...array_merge(...$token[$key])) : pack('q*', ...$token[$key]);
+                $padding = str_repeat($padValue, $length - count($token[$key]));
+
+                $bytes .= $this->paddingSide === 'right' ? $packed . $padding : $padding . $packed;
+            }
+
+            $result[$key] = $isOffsets
+                ? Tensor::fromString($bytes, Tensor::int32, [...$shape, 2])
+                : Tensor::fromString($bytes, Tensor::int64, $shape);
+        }
+
+        return $result;
+    }
+
     /**
      * Encodes a single text or a pair of texts using the model's tokenizer.
      *
      * @param string|null $text The first sequence to encode.
      * @param string|null $textPair The second sequence to encode.
      * @param bool $addSpecialTokens Whether to add the special tokens associated with the corresponding model.
+     * @param string|null $offsetUnit If set, also return the span each token covers, in 'chars' or 'bytes'.
      *
-     * @return array{input_ids: int[], attention_mask: int[], token_type_ids: int[]|null}
+     * @return array{input_ids: int[], attention_mask: int[], token_type_ids: int[]|null, offset_mapping?: array<array{int, int}>}
      */
     public function encodePlus(
         string|null $text,
         string|null $textPair = null,
-        bool        $addSpecialTokens = true
+        bool        $addSpecialTokens = true,
+        ?string     $offsetUnit = null
     ): array {
         // Function called by users to encode possibly multiple texts
         $tokens = $this->encodeText($text);
@@ -409,11 +535,214 @@ class PreTrainedTokenizer
 
         $inputIds = $this->model->convertTokensToIds($combinedTokens->tokens);
 
-        return [
+        $encoded = [
             "input_ids" => $inputIds,
             "attention_mask" => array_fill(0, count($inputIds), 1),
             "token_type_ids" => $combinedTokens->tokenTypeIds,
         ];
+
+        if ($offsetUnit !== null) {
+            $encoded["offset_mapping"] = $this->combineOffsets(
+                $combinedTokens->tokens,
+                [[$text, $tokens], [$textPair, $tokens2]],
+                $offsetUnit === 'bytes'
+            );
+        }
+
+        return $encoded;
+    }
+
+    /**
+     * Lines up the offsets of each encoded sequence with the post-processed tokens. The tokens of the
+     * sequences appear in order among the post-processed ones, and anything else was added by the
+     * post-processor and covers no text.
+     *
+     * @param string[] $combinedTokens The post-processed tokens.
+     * @param array<array{0: string|null, 1: string[]|null}> $sequences The text and tokens of each sequence.
+     * @param bool $inBytes Whether to return byte offsets instead of character offsets.
+     *
+     * @return array<array{int, int}>
+     */
+    protected function combineOffsets(array $combinedTokens, array $sequences, bool $inBytes): array
+    {
+        $expectedTokens = [];
+        $expectedOffsets = [];
+
+        foreach ($sequences as [$text, $tokens]) {
+            if ($text !== null && $tokens !== null) {
+                array_push($expectedTokens, ...$tokens);
+                array_push($expectedOffsets, ...$this->alignOffsets($text, $tokens, $inBytes));
+            }
+        }
+
+        $offsets = [];
+        $k = 0;
+
+        foreach ($combinedTokens as $token) {
+            if ($k < count($expectedTokens) && $expectedTokens[$k] === $token) {
+                $offsets[] = $expectedOffsets[$k++];
+            } else {
+                $offsets[] = [0, 0];
+            }
+        }
+
+        return $offsets;
+    }
+
+    /**
+     * Finds the span of the text each token covers.
+     *
+     * Tokens are mapped back to their surface form and searched for in the text after both are case and
+     * accent folded with whitespace removed, so the spans survive the usual normalizers and pre-tokenizers
+     * without every step having to track alignments. Tokens that cannot be found, like unknown or byte
+     * fallback tokens, cover the gap between their aligned neighbours.
+     *
+     * @param string $text The original text.
+     * @param string[] $tokens The tokens the text was encoded to.
+     * @param bool $inBytes Whether to return byte offsets instead of character offsets.
+     *
+     * @return array<array{int, int}> The [start, end) span of each token.
+     */
+    protected function alignOffsets(string $text, array $tokens, bool $inBytes = false): array
+    {
+        preg_match_all('/./su', $text, $matches, PREG_OFFSET_CAPTURE);
+
+        // The folded characters of the text, each with the byte span of the character it came from
+        $chars = [];
+        $charIndex = [];
+
+        foreach ($matches[0] as $i => [$char, $byte]) {
+            $charIndex[$byte] = $i;
+
+            foreach (self::foldForAlignment($char) as $folded) {
+                $chars[] = [$folded, $byte, $byte + strlen($char)];
+            }
+        }
+
+        $length = strlen($text);
+        $charIndex[$length] = count($matches[0]);
+        $count = count($chars);
+
+        $offsets = [];
+        $pending = [];
+        $cursor = 0;
+        $lastEnd = 0;
+
+        foreach ($tokens as $k => $token) {
+            $needle = self::foldForAlignment($this->tokenSurface($token));
+            $n = count($needle);
+            $found = -1;
+
+            if ($n > 0) {
+                $limit = min($count - $n, $cursor + self::OFFSET_SEARCH_WINDOW);
+
+                for ($i = $cursor; $i <= $limit; $i++) {
+                    $j = 0;
+                    while ($j < $n && $chars[$i + $j][0] === $needle[$j]) {
+                        $j++;
+                    }
+
+                    if ($j === $n) {
+                        $found = $i;
+                        break;
+                    }
+                }
+            }
+
+            if ($found < 0) {
+                $pending[] = $k;
+                continue;
+            }
+
+            $start = $chars[$found][1];
+            foreach ($pending as $p) {
+                $offsets[$p] = [$lastEnd, max($lastEnd, $start)];
+            }
+            $pending = [];
+
+            $offsets[$k] = [$start, $chars[$found + $n - 1][2]];
+            $lastEnd = $offsets[$k][1];
+            $cursor = $found + $n;
+        }
+
+        foreach ($pending as $p) {
+            $offsets[$p] = [$lastEnd, $length];
+        }
+
+        ksort($offsets);
+
+        foreach ($offsets as &$offset) {
+            [$start, $end] = $offset;
+
+            // Gaps are trimmed of surrounding whitespace
+            while ($start < $end && ctype_space($text[$start])) {
+                $start++;
+            }
+            while ($end > $start && ctype_space($text[$end - 1])) {
+                $end--;
+            }
+
+            $offset = $inBytes ? [$start, $end] : [$charIndex[$start], $charIndex[$end]];
+        }
+
+        return $offsets;
+    }
+
+    /**
+     * Returns the text a token stands for, without subword markers.
+     */
+    protected function tokenSurface(string $token): string
+    {
+        $this->addedTokenContents ??= array_fill_keys(array_map(fn($x) => $x->content, $this->addedTokens), true);
+
+        if (isset($this->addedTokenContents[$token])) {
+            return $token;
+        }
+
+        $prefix = $this->model->continuingSubwordPrefix;
+        if ($prefix !== null && $prefix !== '' && str_starts_with($token, $prefix)) {
+            $token = substr($token, strlen($prefix));
+        }
+
+        $suffix = $this->model->endOfWordSuffix;
+        if ($suffix !== null && $suffix !== '' && str_ends_with($token, $suffix)) {
+            $token = substr($token, 0, -strlen($suffix));
+        }
+
+        if ($this->decoder instanceof ByteLevelDecoder) {
+            return $this->decoder->convertTokensToString([$token]);
+        }
+
+        return str_replace("\u{2581}", ' ', $token);
+    }
+
+    /**
+     * Lowercases and strips accents and whitespace from a text, returning the remaining characters.
+     *
+     * @return string[]
+     */
+    protected static function foldForAlignment(string $text): array
+    {
+        $folded = [];
+
+        foreach (mb_str_split($text) as $char) {
+            if (!isset(self::$alignmentFolds[$char])) {
+                $fold = mb_strtolower($char);
+
+                if (class_exists('Normalizer')) {
+                    $decomposed = \Normalizer::normalize($fold, \Normalizer::FORM_KD);
+                    if ($decomposed !== false) {
+                        $fold = preg_replace('/\p{Mn}/u', '', $decomposed);
+                    }
+                }
+
+                self::$alignmentFolds[$char] = mb_str_split(preg_replace('/\s+/u', '', $fold) ?? '');
+            }
+
+            array_push($folded, ...self::$alignmentFolds[$char]);
+        }
+
+        return $folded;
     }
 
     /**
@@ -430,50 +759,51 @@ class PreTrainedTokenizer
         }
 
         // Actual function which does encoding, for a single text
-        // First, we take care of special tokens. Needed to avoid issues arising from
+        // First, we take care of added tokens. Needed to avoid issues arising from
         // normalization and/or pretokenization (which may not preserve special tokens)
-        $sections = $this->addedTokensRegex ? preg_split($this->addedTokensRegex, $text, -1, PREG_SPLIT_DELIM_CAPTURE | PREG_SPLIT_NO_EMPTY) : [$text];
-
-        $tokens = array_map(function ($x, $sectionIndex) {
-            $addedToken = null;
-            foreach ($this->addedTokens as $token) {
-                if ($token->content === $x) {
-                    $addedToken = $token;
-                    break;
-                }
-            }
+        $tokens = [];
+        $sectionIndex = 0;
 
+        foreach ($this->addedTokensMatcher->split($text) as [$section, $addedToken]) {
             if ($addedToken !== null) {
                 // Ignore added tokens
-                return [$x];
-            } else {
-                if ($this->removeSpace) {
-                    $x = preg_replace('/\s+/', ' ', trim($x));
-                }
+                $tokens[] = $addedToken->content;
+                $sectionIndex++;
+                continue;
+            }
 
-                if ($this->doLowerCaseAndRemoveAccent) {
-                    $x = $this->lowerCaseAndRemoveAccents($x);
-                }
+            if ($this->removeSpace) {
+                $section = preg_replace('/\s+/', ' ', trim($section));
+            }
 
-                if ($this->normalizer !== null) {
-                    $x = $this->normalizer->normalize($x);
-                }
+            if ($this->doLowerCaseAndRemoveAccent) {
+                $section = $this->lowerCaseAndRemoveAccents($section);
+            }
 
-                // If, after normalization, this section is empty (e.g., trimming whitespace),
-                // we return an empty array
-                if (mb_strlen($x) === 0) {
-                    return [];
-                }
+            if ($this->normalizer !== null) {
+                $section = $this->normalizer->normalize($section);
+            }
+
+            // Added tokens flagged as normalized can only be found once the section is normalized
+            $subSections = $this->normalizedAddedTokensMatcher?->split($section) ?? [[$section, null]];
 
-                $sectionTokens = $this->preTokenizer !== null
-                    ? $this->preTokenizer->preTokenize($x, ['section_index' => $sectionIndex])
-                    : [$x];
+            foreach ($subSections as [$x, $addedToken]) {
+                if ($addedToken !== null) {
+                    $tokens[] = $addedToken->content;
+                } elseif (mb_strlen($x) > 0) {
+                    // If, after normalization, this section is empty (e.g., trimming whitespace), it adds no tokens
+                    $sectionTokens = $this->preTokenizer !== null
+                        ? $this->preTokenizer->preTokenize($x, ['section_index' => $sectionIndex])
+                        : [$x];
 
-                return $this->model->__invoke($sectionTokens);
+                    array_push($tokens, ...$this->model->__invoke($sectionTokens));
+                }
+
+                $sectionIndex++;
             }
-        }, $sections, array_keys($sections));
+        }
 
-        return array_merge(...$tokens);
+        return $tokens;
     }
 
     /**
@@ -508,7 +838,7 @@ class PreTrainedTokenizer
     protected function padHelper(array &$item, int $length, Closure $value_fn, string $side): void
     {
         foreach (array_keys($item) as $key) {
-            if ($item[$key] == null) return;
+            if ($item[$key] == null) continue;
 
             $diff = $length - count($item[$key]);
             $value = $value_fn($key);
@@ -582,7 +912,7 @@ class PreTrainedTokenizer
         $tokens = $this->model->convertIdsToTokens($tokenIds);
 
         if ($skipSpecialTokens) {
-            $tokens = array_values(array_filter($tokens, fn($x) => !in_array($x, $this->specialTokens)));
+            $tokens = array_values(array_filter($tokens, fn($x) => !isset($this->specialTokenSet[$x])));
         }
 
         // If `this.decoder` is null, we just join tokens with a space:
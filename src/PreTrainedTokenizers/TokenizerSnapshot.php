@@ -0,0 +1,137 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Codewithkyrian\Transformers\PreTrainedTokenizers;
+
+use Codewithkyrian\Transformers\Transformers;
+use Codewithkyrian\Transformers\Utils\Hub;
+use Composer\InstalledVersions;
+use Throwable;
+
+/**
+ * A compiled snapshot of a fully-built tokenizer, stored next to its `tokenizer.json` in the cache directory.
+ *
+ * Restoring a snapshot skips decoding the tokenizer JSON and rebuilding the vocabularies, merge ranks, tries
+ * and normalizer tables, which otherwise dominates the first request of every fresh worker. A snapshot is
+ * keyed by the format version, the library and PHP versions, and the size and modification time of the
+ * source files, so any change to either side simply causes it to be rebuilt.
+ */
+class TokenizerSnapshot
+{
+    /**
+     * Bump whenever the serialized layout of the tokenizer classes changes.
+     */
+    public const VERSION = 3;
+
+    public const FILE_NAME = 'tokenizer.snapshot';
+
+    protected const MAGIC = "TFPHPTOK";
+
+    public function __construct(
+        public readonly string $path,
+        public readonly string $fingerprint,
+    ) {}
+
+    /**
+     * Locates the snapshot for a pretrained tokenizer, downloading the source files if necessary.
+     *
+     * @return static|null The snapshot, or null if snapshots are disabled or the tokenizer has no `tokenizer.json`.
+     */
+    public static function forModel(
+        string    $modelNameOrPath,
+        ?string   $cacheDir = null,
+        string    $revision = 'main',
+        mixed     $legacy = null,
+        ?callable $onProgress = null
+    ): ?static {
+        if (!Transformers::useTokenizerSnapshots()) {
+            return null;
+        }
+
+        $tokenizerFile = Hub::getFile($modelNameOrPath, 'tokenizer.json', $cacheDir, $revision, fatal: false, onProgress: $onProgress);
+
+        if ($tokenizerFile === null || !is_file($tokenizerFile)) {
+            return null;
+        }
+
+        $configFile = Hub::getFile($modelNameOrPath, 'tokenizer_config.json', $cacheDir, $revision, fatal: false, onProgress: $onProgress);
+
+        $sources = [self::VERSION, PHP_VERSION_ID, self::libraryVersion(), serialize($legacy)];
+
+        foreach ([$tokenizerFile, $configFile] as $file) {
+            $sources[] = $file !== null && is_file($file) ? filesize($file) . ':' . filemtime($file) : '-';
+        }
+
+        return new static(
+            dirname($tokenizerFile) . DIRECTORY_SEPARATOR . self::FILE_NAME,
+            sha1(implode('|', $sources))
+        );
+    }
+
+    /**
+     * Restores the tokenizer from the snapshot.
+     *
+     * @return PreTrainedTokenizer|null The tokenizer, or null if the snapshot is missing, stale or unreadable.
+     */
+    public function load(): ?PreTrainedTokenizer
+    {
+        if (!is_file($this->path)) {
+            return null;
+        }
+
+        $contents = @file_get_contents($this->path);
+        $headerLength = strlen(self::MAGIC) + 40;
+
+        if ($contents === false || strlen($contents) <= $headerLength
+            || substr($contents, 0, $headerLength) !== self::MAGIC . $this->fingerprint) {
+            return null;
+        }
+
+        try {
+            $tokenizer = unserialize(substr($contents, $headerLength));
+        } catch (Throwable) {
+            return null;
+        }
+
+        return $tokenizer instanceof PreTrainedTokenizer ? $tokenizer : null;
+    }
+
+    /**
+     * Writes the snapshot. Failures are not fatal since the tokenizer can always be rebuilt from its source files.
+     */
+    public function save(PreTrainedTokenizer $tokenizer): bool
+    {
+        try {
+            $payload = serialize($tokenizer);
+        } catch (Throwable $e) {
+            Transformers::getLogger()->warning('Unable to snapshot tokenizer', ['error' => $e->getMessage()]);
+            return false;
+        }
+
+        // Write to a temporary file first so concurrent workers never read a partial snapshot
+        $tempPath = $this->path . '.' . getmypid() . '.tmp';
+
+        if (@file_put_contents($tempPath, self::MAGIC . $this->fingerprint . $payload) === false) {
+            return false;
+        }
+
+        if (!@rename($tempPath, $this->path)) {
+            @unlink($tempPath);
+            return false;
+        }
+
+        return true;
+    }
+
+    protected static function libraryVersion(): string
+    {
+        if (class_exists(InstalledVersions::class) && InstalledVersions::isInstalled('codewithkyrian/transformers')) {
+            return InstalledVersions::getReference('codewithkyrian/transformers')
+                ?? InstalledVersions::getPrettyVersion('codewithkyrian/transformers')
+                ?? '';
+        }
+
+        return '';
+    }
+}
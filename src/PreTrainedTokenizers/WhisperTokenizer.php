@@ -141,7 +141,8 @@ class WhisperTokenizer extends PreTrainedTokenizer
     /**
      * Decodes automatic speech recognition (ASR) sequences.
      *
-     * @param array $sequences The sequences to decode, each sequence is an associative array with 'tokens', 'token_timestamps', and 'stride'.
+     * @param array $sequences The sequences to decode, each sequence is an associative array with 'tokens', 'token_timestamps',
+     *  'stride' and optionally 'offset', the time in seconds at which the audio of the sequence starts.
      * @param bool $returnTimestamps Whether to return timestamps.
      * @param bool $returnLanguage Whether to return language.
      * @param float $timePrecision The precision of the timestamps in seconds.
@@ -205,6 +206,27 @@ class WhisperTokenizer extends PreTrainedTokenizer
 
                 // Offset the timings to account for the other `model_outputs`.
                 $timeOffset -= $strideLeft;
+
+                // Chunks that do not follow each other, like voiced segments, carry the time their audio starts at.
+                // They don't overlap the previous chunk, so its tokens are resolved on their own, never merged with theirs.
+                if (isset($output['offset'])) {
+                    if (!empty($previousTokens)) {
+                        [$resolvedTokens, $resolvedTokenTimestamps] = $this->findLongestCommonSequence($previousTokens, $previousTokenTimestamps);
+
+                        $chunk['text'] = $this->decode($resolvedTokens);
+                        if ($returnWordTimestamps) {
+                            $chunk['words'] = $this->collateWordTimestamps($resolvedTokens, $resolvedTokenTimestamps, $lastLanguage);
+                        }
+                        $chunks[] = $chunk;
+
+                        $previousTokens = [];
+                        $previousTokenTimestamps = [];
+                        $chunk = $newChunk();
+                    }
+
+                    $timeOffset = $output['offset'];
+                }
+
                 $rightStrideStart = $chunkLen - $strideRight;
 
                 if ($strideLeft) {
@@ -233,7 +255,7 @@ class WhisperTokenizer extends PreTrainedTokenizer
                 // - 2/ all other special tokens (which we ignore)
                 // - 3/ Timestamp
                 // - 4/ Regular text
-                if (in_array($token, $this->allSpecialIds)) {
+                if (isset($this->specialIdSet[$token])) {
                     $text = $this->decode([$token]);
                     $language = self::WHISPER_LANGUAGES[substr($text, 2, -2)] ?? null;
 
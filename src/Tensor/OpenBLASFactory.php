@@ -9,6 +9,7 @@ use FFI;
 use FFI\Exception as FFIException;
 use Rindow\Math\Matrix\Drivers\MatlibPHP\PhpLapack;
 use Rindow\OpenBLAS\FFI\Blas;
+use Rindow\OpenBLAS\FFI\Lapack;
 use RuntimeException;
 
 /**
@@ -16,15 +17,19 @@ use RuntimeException;
 class OpenBLASFactory
 {
     private static ?FFI $ffi = null;
+    private static ?FFI $lapackeFfi = null;
 
 
     /**
-     * @param array<string> $libFiles
-     * @param array<string> $lapackeLibs
+     * @param string $headerFile The CBLAS header.
+     * @param array<string> $libFiles Candidate OpenBLAS libraries, tried in order.
+     * @param string|null $lapackeHeaderFile The LAPACKE header. Its functions are resolved from the same
+     *  library as CBLAS; if they can't be, LAPACK falls back to the PHP implementation.
      */
     public function __construct(
-        string $headerFile,
-        array  $libFiles,
+        string  $headerFile,
+        array   $libFiles,
+        ?string $lapackeHeaderFile = null,
     )
     {
         if (self::$ffi !== null) {
@@ -44,6 +49,14 @@ class OpenBLASFactory
             }
 
             self::$ffi = $ffi;
+
+            if ($lapackeHeaderFile !== null) {
+                try {
+                    self::$lapackeFfi = FFI::cdef(file_get_contents($lapackeHeaderFile), $filename);
+                } catch (FFIException $e) {
+                    // OpenBLAS built without LAPACKE, keep the PHP implementation
+                }
+            }
             break;
         }
     }
@@ -61,8 +74,11 @@ class OpenBLASFactory
         return new Blas(self::$ffi);
     }
 
-    public function Lapack(): PhpLapack
+    public function Lapack(): Lapack|PhpLapack
     {
-        return new PhpLapack();
+        if (self::$lapackeFfi === null) {
+            return new PhpLapack();
+        }
+        return new Lapack(self::$lapackeFfi);
     }
-}
\ No newline at end of file
+}
@@ -5,8 +5,10 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers\Tensor;
 
 use ArrayObject;
+use Codewithkyrian\Transformers\FFI\Libc;
 use Countable;
 use EmptyIterator;
+use FFI;
 use Interop\Polite\Math\Matrix\Buffer;
 use Interop\Polite\Math\Matrix\NDArray;
 use InvalidArgumentException;
@@ -31,6 +33,11 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
 
     const SERIALIZE_NDARRAY_KEYWORD = 'Tensor:';
 
+    /**
+     * Maximum number of values handed to a single `pack()` call when building a tensor from an array.
+     */
+    const PACK_CHUNK_SIZE = 65536;
+
     protected static MatrixOperator $mo;
     protected static Service $service;
 
@@ -58,6 +65,23 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
         NDArray::complex128 => 'e',
     ];
 
+    /** @var array<int,string> NumPy `.npy` type descriptors for each dtype */
+    protected static array $npyDescr = [
+        NDArray::bool => '|b1',
+        NDArray::int8 => '|i1',
+        NDArray::int16 => '<i2',
+        NDArray::int32 => '<i4',
+        NDArray::int64 => '<i8',
+        NDArray::uint8 => '|u1',
+        NDArray::uint16 => '<u2',
+        NDArray::uint32 => '<u4',
+        NDArray::uint64 => '<u8',
+        NDArray::float32 => '<f4',
+        NDArray::float64 => '<f8',
+        NDArray::complex64 => '<c8',
+        NDArray::complex128 => '<c16',
+    ];
+
     protected bool $portableSerializeMode = false;
 
     public function __construct(
@@ -89,6 +113,12 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
             $this->buffer = $array;
             $this->offset = $offset;
             $size = (int)array_product($shape);
+        } elseif (is_array($array) && ($packed = $this->packArray($array, $dtype, $arrayShape)) !== null) {
+            $size = (int)array_product($arrayShape);
+            $this->buffer = self::newBuffer($size, $dtype);
+            $this->buffer->load($packed);
+            $this->offset = 0;
+            $shape ??= $arrayShape;
         } elseif (is_array($array) || $array instanceof ArrayObject) {
             $size = $this->countRecursive($array);
             $this->buffer = self::newBuffer($size, $dtype);
@@ -234,6 +264,119 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
         return $numElements;
     }
 
+    /**
+     * Pack a rectangular nested array of scalars into the binary layout of the given dtype.
+     *
+     * The shape is inferred once from the first element of every level, and each row is
+     * packed with a single `pack()` call instead of writing elements one by one. Returns
+     * null when the array cannot take this path (complex dtype, empty or non-list arrays),
+     * so the caller can fall back to the element-wise flattening.
+     */
+    protected function packArray(array $array, int $dtype, ?array &$shape = null): ?string
+    {
+        if ($this->isComplex($dtype) || !isset(self::$pack[$dtype])) {
+            return null;
+        }
+
+        $shape = $this->generateShape($array);
+        $ndim = count($shape);
+
+        if (in_array(0, $shape, true)) {
+            return null;
+        }
+
+        // A recursive count catches leaves nested deeper than the inferred shape.
+        $expectedCount = 0;
+        $levelCount = 1;
+        foreach ($shape as $dim) {
+            $levelCount *= $dim;
+            $expectedCount += $levelCount;
+        }
+
+        if (count($array, COUNT_RECURSIVE) !== $expectedCount) {
+            return null;
+        }
+
+        $rows = [$array];
+
+        for ($axis = 0; $axis < $ndim - 1; $axis++) {
+            $next = [];
+            foreach ($rows as $row) {
+                if (!is_array($row) || !array_is_list($row)) {
+                    return null;
+                }
+                if (count($row) !== $shape[$axis]) {
+                    throw new InvalidArgumentException("The shape of the dimension is broken");
+                }
+                array_push($next, ...$row);
+            }
+            $rows = $next;
+        }
+
+        $lastDim = $shape[$ndim - 1];
+        $packed = [];
+
+        foreach ($rows as $row) {
+            if (!is_array($row) || !array_is_list($row)) {
+                return null;
+            }
+            if (count($row) !== $lastDim) {
+                throw new InvalidArgumentException("The shape of the dimension is broken");
+            }
+
+            $packed[] = self::packValues($row, $dtype);
+        }
+
+        return implode('', $packed);
+    }
+
+    /**
+     * Pack a flat list of scalars into the binary layout of the given dtype.
+     */
+    protected static function packValues(array $values, int $dtype): string
+    {
+        $format = self::$pack[$dtype] . '*';
+
+        if (count($values) <= self::PACK_CHUNK_SIZE) {
+            return pack($format, ...$values);
+        }
+
+        $packed = [];
+        foreach (array_chunk($values, self::PACK_CHUNK_SIZE) as $chunk) {
+            $packed[] = pack($format, ...$chunk);
+        }
+
+        return implode('', $packed);
+    }
+
+    /**
+     * Unpack the tensor's elements into a nested array in a single pass over the buffer.
+     *
+     * Returns null when the fast path does not apply (complex dtype, empty tensor or a
+     * buffer that isn't backed by native memory).
+     */
+    protected function unpackArray(): ?array
+    {
+        $size = $this->size();
+
+        if ($size === 0 || $this->isComplex() || !($this->buffer instanceof TensorBuffer)) {
+            return null;
+        }
+
+        $bytes = FFI::string($this->buffer->addr($this->offset), $size * $this->buffer->valueSize());
+        $values = array_values(unpack(self::$pack[$this->dtype] . '*', $bytes));
+
+        if ($this->dtype === NDArray::bool) {
+            $values = array_map('boolval', $values);
+        }
+
+        for ($axis = $this->ndim() - 1; $axis > 0; $axis--) {
+            $values = array_chunk($values, $this->shape[$axis]);
+        }
+
+        return $values;
+    }
+
     /**
      * Unflatten the given flat array into a nested array according to the given shape.
      */
@@ -389,6 +532,129 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
         return new static($buffer, $dtype, $shape, 0);
     }
 
+    /**
+     * Save the tensor to a NumPy `.npy` file (format version 1.0).
+     *
+     * The header is padded so the raw data starts on a 64-byte boundary, which lets `load()` map
+     * the file and use the data in place.
+     *
+     * @param string $path The file to write to.
+     */
+    public function save(string $path): void
+    {
+        if (!isset(self::$npyDescr[$this->dtype])) {
+            throw new InvalidArgumentException("Unsupported dtype for .npy serialization: $this->dtype");
+        }
+
+        $shape = match (count($this->shape)) {
+            0 => '()',
+            1 => "({$this->shape[0]},)",
+            default => '(' . implode(', ', $this->shape) . ')',
+        };
+
+        $header = "{'descr': '" . self::$npyDescr[$this->dtype] . "', 'fortran_order': False, 'shape': $shape, }";
+        $preambleLength = 10; // magic (6) + version (2) + header length (2)
+        $padding = 64 - (($preambleLength + strlen($header) + 1) % 64);
+        $header .= str_repeat(' ', $padding % 64) . "\n";
+
+        $file = fopen($path, 'wb');
+        if ($file === false) {
+            throw new RuntimeException("Unable to open $path for writing");
+        }
+
+        try {
+            fwrite($file, "\x93NUMPY\x01\x00" . pack('v', strlen($header)) . $header);
+
+            $size = $this->size();
+            $valueSize = TensorBuffer::$valueSize[$this->dtype];
+
+            if (!($this->buffer instanceof TensorBuffer)) {
+                fwrite($file, substr($this->buffer->dump(), $this->offset * $valueSize, $size * $valueSize));
+                return;
+            }
+
+            // Write in chunks so large tensors aren't copied into a single PHP string.
+            $chunkSize = intdiv(16 * 1024 * 1024, $valueSize);
+            for ($start = 0; $start < $size; $start += $chunkSize) {
+                $count = min($chunkSize, $size - $start);
+                fwrite($file, FFI::string($this->buffer->addr($this->offset + $start), $count * $valueSize));
+            }
+        } finally {
+            fclose($file);
+        }
+    }
+
+    /**
+     * Load a tensor from a NumPy `.npy` file, such as one written by `save()`.
+     *
+     * By default, the file is memory-mapped copy-on-write: loading is instant regardless of size, the pages
+     * are only read when accessed and are shared between processes loading the same file. Modifying the
+     * tensor never writes back to the file.
+     *
+     * @param string $path The file to read.
+     * @param bool $mmap Whether to map the file instead of reading it into memory. Ignored on Windows.
+     */
+    public static function load(string $path, bool $mmap = true): static
+    {
+        $file = fopen($path, 'rb');
+        if ($file === false) {
+            throw new RuntimeException("Unable to open $path for reading");
+        }
+
+        try {
+            $preamble = fread($file, 10);
+            if (strlen($preamble) < 10 || !str_starts_with($preamble, "\x93NUMPY")) {
+                throw new RuntimeException("$path is not a valid .npy file");
+            }
+
+            $major = ord($preamble[6]);
+            if ($major === 1) {
+                $headerLength = unpack('v', $preamble, 8)[1];
+                $dataOffset = 10 + $headerLength;
+            } else {
+                $headerLength = unpack('V', $preamble . fread($file, 2), 8)[1];
+                $dataOffset = 12 + $headerLength;
+            }
+
+            $header = fread($file, $headerLength);
+
+            if (!preg_match("/'descr':\s*'([^']+)'/", $header, $descr)
+                || !preg_match("/'shape':\s*\(([^)]*)\)/", $header, $shape)) {
+                throw new RuntimeException("Invalid .npy header in $path");
+            }
+
+            if (preg_match("/'fortran_order':\s*True/", $header)) {
+                throw new RuntimeException("Fortran-ordered .npy files are not supported");
+            }
+
+            $dtype = array_search(str_replace('=', '<', $descr[1]), self::$npyDescr, true);
+            if ($dtype === false) {
+                throw new RuntimeException("Unsupported .npy dtype: {$descr[1]}");
+            }
+
+            $shape = array_values(array_map('intval', array_filter(array_map('trim', explode(',', $shape[1])), 'strlen')));
+            $size = (int)array_product($shape);
+            $byteSize = $size * TensorBuffer::$valueSize[$dtype];
+
+            if (filesize($path) < $dataOffset + $byteSize) {
+                throw new RuntimeException("$path is truncated: expected $byteSize bytes of data");
+            }
+
+            if ($mmap && Libc::canMapFiles()) {
+                $buffer = TensorBuffer::fromMappedFile($path, $dataOffset, $size, $dtype);
+            } else {
+                $buffer = self::newBuffer($size, $dtype);
+                if ($byteSize > 0) {
+                    $buffer->load(stream_get_contents($file, $byteSize, $dataOffset));
+                }
+            }
+        } finally {
+            fclose($file);
+        }
+
+        return new static($buffer, $dtype, $shape, 0);
+    }
+
     public static function random(array $shape, ?int $dtype = null): static
     {
         $dtype ??= NDArray::float32;
@@ -408,6 +674,10 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
             return $this->buffer[$this->offset];
         }
 
+        if (($array = $this->unpackArray()) !== null) {
+            return $array;
+        }
+
         $idx = $this->offset;
 
         return $this->unflattenArray($this->buffer, $idx, $this->shape);
@@ -814,32 +1084,22 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
      */
     public function normalize(int $p = 2, ?int $axis = null): static
     {
-        $result = clone $this;
+        $la = self::mo()->la();
 
-        $axis = $result->safeIndex($axis, $result->ndim());
+        $result = $la->copy($this);
+        $result = new static($result->buffer(), $result->dtype(), $this->shape(), $result->offset());
 
-        $norm = $result->norm($p, $axis, true);
-
-        foreach ($norm->buffer as $i => $value) {
-            $resultIndex = 0;
-            $num = $i;
-            $resultMultiplier = 1;
+        if ($axis === null) {
+            $la->scal(1 / $this->norm($p)->toArray(), $result);
 
-            for ($j = $result->ndim() - 1; $j >= 0; --$j) {
-                $size = $result->shape()[$j];
+            return $result;
+        }
 
-                if ($j !== $axis) {
-                    $index = $num % $size;
-                    $resultIndex += $index * $resultMultiplier;
-                    $resultMultiplier *= $result->shape()[$j];
-                }
+        $axis = $this->safeIndex($axis, $this->ndim());
 
-                $num = floor($num / $size);
-            }
+        $norm = $la->reciprocal($this->norm($p, $axis, true));
 
-            // Divide by normalized value
-            $result->buffer[$i] /= $norm->buffer[$resultIndex];
-        }
+        $result->broadcastAlongAxis(fn($x, $a, $trans) => $la->multiply($x, $a, $trans), $norm, $axis);
 
         return $result;
     }
@@ -856,9 +1116,19 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
     public function norm(int $ord = 2, ?int $axis = null, bool $keepShape = false): static
     {
         $mo = self::mo();
+        $la = $mo->la();
+
+        // The driver's math functions work in place, so compute |x|^ord on a copy.
+        $powered = $la->pow($la->copy($this), 2.0);
+        if ($ord !== 2) {
+            $la->sqrt($powered);
+            if ($ord !== 1) {
+                $la->pow($powered, (float)$ord);
+            }
+        }
 
         if ($axis === null) {
-            $val = pow(array_reduce($this->toBufferArray(), fn($carry, $item) => $carry + pow($item, $ord), 0), 1 / $ord);
+            $val = pow($mo->sum($powered), 1 / $ord);
 
             return new Tensor([$val], $this->dtype(), []);
         }
@@ -866,45 +1136,60 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
         // Negative indexing
         $axis = $this->safeIndex($axis, $this->ndim());
 
-        // Calculate the shape of the resulting array after summation
+        $result = $la->reduceSum($powered, $axis);
+
+        if ($ord !== 1) {
+            $la->pow($result, 1 / $ord);
+        }
+
         $resultShape = $this->shape();
-        $resultShape[$axis] = 1; // Remove the specified axis
+        $resultShape[$axis] = 1;
 
-        // Create a new array to store the accumulated values
-        $result = $this->zeros([count($this->buffer) / $this->shape()[$axis]]);
+        if (!$keepShape) {
+            array_splice($resultShape, $axis, 1);
+        }
 
-        // Iterate over the data array
-        foreach ($this->buffer as $i => $value) {
-            // Calculate the index in the resulting array
-            $resultIndex = 0;
-            $num = $i;
-            $resultMultiplier = 1;
+        return new static($result->buffer(), $result->dtype(), $resultShape, $result->offset());
+    }
 
-            for ($j = $this->ndim() - 1; $j >= 0; --$j) {
-                $size = $this->shape()[$j];
+    /**
+     * Split the shape around the given axis into the number of outer rows, the axis length and
+     * the number of inner elements, i.e. view the tensor as `[outer, dim, inner]`.
+     *
+     * @return int[]
+     */
+    protected function axisBounds(int $axis): array
+    {
+        $outer = (int)array_product(array_slice($this->shape, 0, $axis));
+        $inner = (int)array_product(array_slice($this->shape, $axis + 1));
 
-                if ($j !== $axis) {
-                    $index = $num % $size;
-                    $resultIndex += $index * $resultMultiplier;
-                    $resultMultiplier *= $resultShape[$j];
-                }
+        return [$outer, $this->shape[$axis], $inner];
+    }
 
-                $num = floor($num / $size);
-            }
+    /**
+     * Apply an in-place driver operation between this tensor and a tensor reduced over `$axis`,
+     * broadcasting the reduced values back along that axis.
+     *
+     * @param callable(NDArray, NDArray, bool): NDArray $op Called as `$op($reduced, $target, $trans)`.
+     * @param Tensor $reduced The reduced tensor, with `$axis` either kept as 1 or removed.
+     * @param int $axis The (non-negative) axis that was reduced.
+     */
+    protected function broadcastAlongAxis(callable $op, Tensor $reduced, int $axis): void
+    {
+        [$outer, $dim, $inner] = $this->axisBounds($axis);
 
-            // Accumulate the value at the current index
-            $result[$resultIndex] += pow($this->buffer[$i], $ord);
+        // Reducing the last axis: one value per row, broadcast with a transposed operation.
+        if ($inner === 1) {
+            $op($reduced->reshape([$outer]), $this->reshape([$outer, $dim]), true);
+            return;
         }
 
-        if ($ord === 1) {
-            $result = $mo->op($result, '**', 1 / $ord);
-        }
+        $source = $reduced->reshape([$outer, $inner]);
+        $target = $this->reshape([$outer, $dim, $inner]);
 
-        if (!$keepShape) {
-            array_splice($resultShape, $axis, 1);
+        for ($i = 0; $i < $outer; ++$i) {
+            $op($source[$i], $target[$i], false);
         }
-
-        return new static($result->buffer(), $result->dtype(), $resultShape, $result->offset());
     }
 
 
@@ -1000,14 +1285,15 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
     public function stdMean(?int $axis = null, int $correction = 1, bool $keepShape = false): array
     {
         $mo = self::mo();
+        $la = $mo->la();
 
         if ($axis === null) {
             $mean = $mo->mean($this);
             $std = sqrt(
                 $mo->sum(
-                    $mo->la()->pow(
-                        $mo->la()->increment($this, -$mean),
-                        2
+                    $la->pow(
+                        $la->increment($la->copy($this), -$mean),
+                        2.0
                     )
                 ) / ($this->size() - $correction)
             );
@@ -1017,48 +1303,36 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
 
         $axis = $this->safeIndex($axis, $this->ndim());
 
-        $mean = $this->mean($axis, $keepShape);
-
-        $resultShape = $this->shape();
-        $resultShape[$axis] = 1;
-
-        $result = $this->zeros([$this->size() / $this->shape[$axis]], $this->dtype());
+        $mean = $this->mean($axis, true);
 
-        for ($i = 0; $i < $this->size(); ++$i) {
-            $resultIndex = 0;
-            $num = $i;
-            $resultMultiplier = 1;
+        $centered = $la->copy($this);
+        $centered = new static($centered->buffer(), $centered->dtype(), $this->shape(), $centered->offset());
+        $centered->broadcastAlongAxis(fn($x, $a, $trans) => $la->add($x, $a, -1.0, $trans), $mean, $axis);
 
-            for ($j = $this->ndim() - 1; $j >= 0; --$j) {
-                $size = $this->shape[$j];
+        $variance = $la->reduceSum($la->pow($centered, 2.0), $axis);
+        $la->scal(1 / ($this->shape[$axis] - $correction), $variance);
+        $std = $la->sqrt($variance);
 
-                if ($j !== $axis) {
-                    $index = $num % $size;
-                    $resultIndex += $index * $resultMultiplier;
-                    $resultMultiplier *= $resultShape[$j];
-                }
-
-                $num = floor($num / $size);
-            }
-
-            $result->buffer[$resultIndex] += pow($this->buffer[$i] - $mean->buffer[$resultIndex], 2);
-        }
-
-        for ($i = 0; $i < count($result->buffer); ++$i) {
-            $result->buffer[$i] = sqrt($result->buffer[$i] / ($this->shape[$axis] - $correction));
-        }
+        $resultShape = $this->shape();
+        $resultShape[$axis] = 1;
 
         if (!$keepShape) {
             array_splice($resultShape, $axis, 1);
         }
 
-        return [$result->reshape($resultShape), $mean];
+        return [
+            new static($std->buffer(), $std->dtype(), $resultShape, $std->offset()),
+            $mean->reshape($resultShape),
+        ];
     }
 
 
     /**
      * Perform mean pooling of the last hidden state (shape : [batchSize, seqLength, embedDim])
      *
+     * Each row is pooled with a single `gemv` (mask^T · hiddenStates), so the work runs in OpenBLAS
+     * rather than element by element.
+     *
      * @param Tensor $other The other tensor of shape : [batchSize, seqLength]
      *
      * @return Tensor The pooled tensor of shape : [batchSize, embedDim]
@@ -1067,31 +1341,45 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
     {
         [$batchSize, $seqLength, $embedDim] = $this->shape();
 
+        $la = self::mo()->la();
+
+        $mask = $other->to($this->dtype())->reshape([$batchSize, $seqLength]);
+        $counts = $la->reduceSum($mask, 1);
+
         $pooledTensor = Tensor::zeros([$batchSize, $embedDim], $this->dtype());
-        $outIndex = 0;
 
         for ($i = 0; $i < $batchSize; ++$i) {
-            $offset = $i * $embedDim * $seqLength;
+            $count = max($counts[$i], 1e-9);
 
-            for ($k = 0; $k < $embedDim; ++$k) {
-                $sum = 0;
-                $count = 0;
+            $la->gemv($this[$i], $mask[$i], 1 / $count, 0.0, $pooledTensor[$i], true);
+        }
 
-                $otherOffset = $i * $seqLength;
-                $offset2 = $offset + $k;
+        return $pooledTensor;
+    }
 
-                // Pool over all words in sequence
-                for ($j = 0; $j < $seqLength; ++$j) {
-                    // index into attention mask
-                    $attn = $other->buffer[$otherOffset + $j];
+    /**
+     * Pool the last hidden state (shape : [batchSize, seqLength, embedDim]) by taking the last
+     * non-padding token of each sequence. Works for both left- and right-padded batches.
+     *
+     * @param Tensor $attentionMask The attention mask of shape : [batchSize, seqLength]
+     *
+     * @return Tensor The pooled tensor of shape : [batchSize, embedDim]
+     */
+    public function lastTokenPooling(Tensor $attentionMask): Tensor
+    {
+        [$batchSize, $seqLength, $embedDim] = $this->shape();
 
-                    $count += $attn;
-                    $sum += $this->buffer[$offset2 + $j * $embedDim] * $attn;
-                }
+        $la = self::mo()->la();
 
-                $avg = $sum / $count;
-                $pooledTensor->buffer[$outIndex++] = $avg;
-            }
+        $mask = $attentionMask->to(NDArray::float32)->reshape([$batchSize, $seqLength]);
+        $lengths = $la->reduceSum($mask, 1);
+
+        $pooledTensor = Tensor::zeros([$batchSize, $embedDim], $this->dtype());
+
+        for ($i = 0; $i < $batchSize; ++$i) {
+            $index = $mask[$i][$seqLength - 1] > 0 ? $seqLength - 1 : max((int)$lengths[$i] - 1, 0);
+
+            $la->copy($this[$i][$index], $pooledTensor[$i]);
         }
 
         return $pooledTensor;
@@ -1248,102 +1536,81 @@ class Tensor implements NDArray, Countable, Serializable, IteratorAggregate
 
 
     /**
-     * Calculate the top k values and indices of the tensor.
+     * Calculate the top k values and indices of the tensor along the given axis.
+     *
+     * Each row along the axis is unpacked from native memory in one pass and ranked with PHP's
+     * built-in (C) sort, rather than a heap maintained in userland.
      *
-     * @param ?int $k The number of top values to return.
-     * @param bool $sorted Whether to return the top values in sorted order.
+     * @param int $k The number of top values to return. -1 returns every value along the axis.
+     * @param bool $sorted Whether to return the top values in sorted order. Kept for compatibility;
+     *  values are always returned in descending order.
+     * @param int $axis The axis to select along. Defaults to the last axis.
      *
-     * @return array The top k values and indices of the tensor.
+     * @return array{0: static, 1: static} The top k values and their int64 indices along the axis.
      */
-    public function topk(int $k = -1, bool $sorted = true): array
+    public function topk(int $k = -1, bool $sorted = true, int $axis = -1): array
     {
-        if ($k === -1) {
-            $k = $this->shape[0];
-        }
-
         $ndim = $this->ndim();
 
-
-        if ($ndim > 2) {
-            throw new InvalidArgumentException("TopK is only supported for 1D and 2D tensors.");
+        if ($ndim === 0) {
+            throw new InvalidArgumentException("TopK is not supported for scalar tensors.");
         }
 
-        // TODO: Switch to using the MatrixOperator after the PR is merged
-
-        $m = $ndim == 1 ? 1 : $this->shape[0];
-        $n = $ndim == 1 ? $this->shape[0] : $this->shape[1];
+        $axis = $this->safeIndex($axis, $ndim);
+        $n = $this->shape[$axis];
 
-        $topValues = Tensor::zeros([$m, $k], dtype: $this->dtype());
-        $topIndices = Tensor::zeros([$m, $k], dtype: NDArray::int32);
+        if ($k === -1 || $k > $n) {
+            $k = $n;
+        }
 
-        $offsetTV = $topValues->offset();
-        $offsetTI = $topIndices->offset();
+        // Move the axis to the end so that each row along it is contiguous.
+        $axes = range(0, $ndim - 1);
+        array_splice($axes, $axis, 1);
+        $axes[] = $axis;
 
-        $meanHeapify = function (array &$heap, int $i, int $k) {
-            $smallest = $i;
-            $left = 2 * $i + 1;
-            $right = 2 * $i + 2;
+        $input = $axis === $ndim - 1 ? $this : $this->permute(...$axes);
 
-            while ($left < $k) {
-                if ($right < $k && $heap[$right]['value'] < $heap[$left]['value']) {
-                    $smallest = $right;
-                } else {
-                    $smallest = $left;
-                }
+        $outputShape = $input->shape();
+        $outputShape[$ndim - 1] = $k;
 
-                if ($heap[$smallest]['value'] >= $heap[$i]['value']) {
-                    break;
-                }
-
-                // Swap heap[i] and heap[smallest]
-                $temp = $heap[$i];
-                $heap[$i] = $heap[$smallest];
-                $heap[$smallest] = $temp;
+        if ($k === 0 || $n === 0) {
+            $topValues = Tensor::zeros($outputShape, $this->dtype());
+            $topIndices = Tensor::zeros($outputShape, NDArray::int64);
+        } else {
+            $size = $input->size();
+            $bytes = $input->buffer instanceof TensorBuffer
+                ? FFI::string($input->buffer->addr($input->offset), $size * TensorBuffer::$valueSize[$input->dtype])
+                : substr($input->buffer->dump(), $input->offset * TensorBuffer::$valueSize[$input->dtype], $size * TensorBuffer::$valueSize[$input->dtype]);
 
-                $i = $smallest;
-                $left = 2 * $i + 1;
-                $right = 2 * $i + 2;
-            }
-        };
+            $data = array_values(unpack(self::$pack[$input->dtype] . '*', $bytes));
 
+            $values = [];
+            $indices = [];
 
-        for ($i = 0; $i < $m; $i++) {
-            $idA = $this->offset + $i * $n;
+            foreach (array_chunk($data, $n) as $row) {
+                arsort($row);
 
-            // Create an array to represent the heap and initialize with the first k elements
-            $heap = [];
-            for ($j = 0; $j < $k; $j++) {
-                $heap[] = ['value' => $this->buffer[$idA + $j], 'index' => $j];
-            }
+                if ($k < $n) {
+                    $row = array_slice($row, 0, $k, true);
+                }
 
-            // Build a min-heap with the first k elements
-            $k = count($heap);
-            for ($j = intdiv($k, 2) - 1; $j >= 0; $j--) {
-                $meanHeapify($heap, $j, $k);
+                array_push($values, ...array_values($row));
+                array_push($indices, ...array_keys($row));
             }
 
-            // Iterate through the remaining elements in the row
-            for ($j = $k; $j < $n; $j++) {
-                $currentValue = $this->buffer[$idA + $j];
-                if ($currentValue > $heap[0]['value']) {
-                    $heap[0] = ['value' => $currentValue, 'index' => $j];
-                    $meanHeapify($heap, 0, $k);
-                }
-            }
+            $topValues = Tensor::fromString(self::packValues($values, $this->dtype()), $this->dtype(), $outputShape);
+            $topIndices = Tensor::fromString(self::packValues($indices, NDArray::int64), NDArray::int64, $outputShape);
+        }
 
-            if ($sorted) {
-                // Sort the heap to get the top k elements in descending order
-                usort($heap, fn($a, $b) => $b['value'] <=> $a['value']);
-            }
+        if ($axis !== $ndim - 1) {
+            $inverse = array_flip($axes);
+            ksort($inverse);
 
-            // Extract top K values and indices from the heap
-            for ($j = 0; $j < $k; $j++) {
-                $topValues->buffer[$offsetTV + ($i * $k) + $j] = $heap[$j]['value'];
-                $topIndices->buffer[$offsetTI + ($i * $k) + $j] = $heap[$j]['index'];
-            }
+            $topValues = $topValues->permute(...$inverse);
+            $topIndices = $topIndices->permute(...$inverse);
         }
 
-        return $ndim == 1 ? [$topValues->squeeze(0), $topIndices->squeeze(0)] : [$topValues, $topIndices];
+        return [$topValues, $topIndices];
     }
 
     public function f(callable $callback, mixed ...$args): static
@@ -2,7 +2,9 @@
 
 namespace Codewithkyrian\Transformers\Tensor;
 
+use Codewithkyrian\Transformers\FFI\Libc;
 use FFI;
+use FFI\CData;
 use Interop\Polite\Math\Matrix\LinearBuffer;
 use Interop\Polite\Math\Matrix\NDArray;
 use InvalidArgumentException;
@@ -66,6 +68,12 @@ class TensorBuffer implements LinearBuffer
     protected int $dtype;
     protected object $data;
 
+    /**
+     * Base address and length of the file mapping backing this buffer, if any.
+     */
+    protected ?CData $mapping = null;
+    protected int $mappingLength = 0;
+
     public function __construct(int $size, int $dtype)
     {
         if (self::$ffi === null) {
@@ -97,6 +105,47 @@ class TensorBuffer implements LinearBuffer
 
     }
 
+    /**
+     * Create a buffer backed by a private, copy-on-write memory mapping of a file.
+     *
+     * The pages are shared with every other process mapping the same file until they are written to,
+     * and nothing is read from disk until the data is first accessed.
+     *
+     * @param string $path The file to map.
+     * @param int $dataOffset The byte offset of the first element within the file.
+     * @param int $size The number of elements.
+     * @param int $dtype The data type of the elements.
+     */
+    public static function fromMappedFile(string $path, int $dataOffset, int $size, int $dtype): static
+    {
+        $buffer = new static(0, $dtype);
+
+        if ($size === 0) {
+            return $buffer;
+        }
+
+        $length = $dataOffset + $size * self::$valueSize[$dtype];
+        $mapping = Libc::mapFile($path, $length);
+
+        $declaration = self::$typeString[$dtype];
+        $dataPtr = self::$ffi->cast('char *', $mapping) + $dataOffset;
+
+        $buffer->size = $size;
+        $buffer->data = self::$ffi->cast("{$declaration}(*)[{$size}]", $dataPtr)[0];
+        $buffer->mapping = $mapping;
+        $buffer->mappingLength = $length;
+
+        return $buffer;
+    }
+
+    public function __destruct()
+    {
+        if ($this->mapping !== null) {
+            Libc::unmapFile($this->mapping, $this->mappingLength);
+            $this->mapping = null;
+        }
+    }
+
     protected function assertOffset(string $method, mixed $offset): void
     {
         if (!is_int($offset)) {
@@ -217,5 +266,8 @@ class TensorBuffer implements LinearBuffer
     public function __clone()
     {
         $this->data = clone $this->data;
+        // The clone owns a private copy of the data, the mapping stays with the original.
+        $this->mapping = null;
+        $this->mappingLength = 0;
     }
 }
@@ -20,6 +20,7 @@ class TensorService extends AbstractMatlibService
         $this->openblasFactory = new OpenBLASFactory(
             headerFile: $openBlas->getHeaderPath(),
             libFiles: [$openBlas->getLibraryPath()],
+            lapackeHeaderFile: $openBlas->getLapackeHeaderPath(),
         );
 
         $rindowMatlib = new RindowMatlib();
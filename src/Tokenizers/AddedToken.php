@@ -25,7 +25,7 @@ class AddedToken
         /**
          * Whether this token must be a single word or can break words.
          */
-        public readonly bool $singleWord = true,
+        public readonly bool $singleWord = false,
         /**
          * Whether this token should strip whitespaces on its left.
          */
@@ -51,7 +51,7 @@ class AddedToken
         return new self(
             $config['content'],
             $config['id'],
-            $config['single_word'] ?? true,
+            $config['single_word'] ?? false,
             $config['lstrip'] ?? false,
             $config['rstrip'] ?? false,
             $config['normalized'] ?? true,
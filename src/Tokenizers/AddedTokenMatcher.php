@@ -0,0 +1,236 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Tokenizers;
+
+/**
+ * Splits text around added tokens with an Aho-Corasick automaton over the bytes of their contents.
+ *
+ * Matching is leftmost-longest, like the Hugging Face tokenizers library, and honours each token's
+ * `single_word`, `lstrip` and `rstrip` options. The cost of a split is linear in the length of the text
+ * plus the number of candidate matches, independently of how many tokens were added.
+ */
+class AddedTokenMatcher
+{
+    /** @var array<int, array<string, int>> Trie transitions, keyed by state then byte. */
+    protected array $transitions = [[]];
+
+    /** @var int[] Failure link of each state. */
+    protected array $fail = [0];
+
+    /** @var array<int, int[]> Indices of the patterns ending at each state, including through failure links. */
+    protected array $outputs = [];
+
+    /** @var string[] The byte patterns, aligned with `$tokens`. */
+    protected array $patterns = [];
+
+    /**
+     * @param AddedToken[] $tokens The tokens to match.
+     * @param callable(string): string|null $transform Maps a token's content to the pattern to search for,
+     *  e.g. to match normalized tokens against normalized text.
+     */
+    public function __construct(protected array $tokens, ?callable $transform = null)
+    {
+        $this->tokens = array_values($tokens);
+
+        foreach ($this->tokens as $index => $token) {
+            $pattern = $transform !== null ? $transform($token->content) : $token->content;
+            $this->patterns[$index] = $pattern;
+
+            if ($pattern === '') {
+                continue;
+            }
+
+            $state = 0;
+            $length = strlen($pattern);
+
+            for ($i = 0; $i < $length; $i++) {
+                $byte = $pattern[$i];
+
+                if (!isset($this->transitions[$state][$byte])) {
+                    $this->transitions[$state][$byte] = count($this->transitions);
+                    $this->transitions[] = [];
+                    $this->fail[] = 0;
+                }
+
+                $state = $this->transitions[$state][$byte];
+            }
+
+            $this->outputs[$state][] = $index;
+        }
+
+        // Breadth-first pass to link every state to its longest proper suffix in the trie
+        $queue = array_values($this->transitions[0]);
+
+        for ($head = 0; $head < count($queue); $head++) {
+            $state = $queue[$head];
+
+            foreach ($this->transitions[$state] as $byte => $next) {
+                $fallback = $this->fail[$state];
+
+                while ($fallback !== 0 && !isset($this->transitions[$fallback][$byte])) {
+                    $fallback = $this->fail[$fallback];
+                }
+
+                $this->fail[$next] = $this->transitions[$fallback][$byte] ?? 0;
+
+                if (isset($this->outputs[$this->fail[$next]])) {
+                    $this->outputs[$next] = [...($this->outputs[$next] ?? []), ...$this->outputs[$this->fail[$next]]];
+                }
+
+                $queue[] = $next;
+            }
+        }
+    }
+
+    /**
+     * Whether the matcher has any token to look for.
+     */
+    public function isEmpty(): bool
+    {
+        return count($this->transitions) === 1;
+    }
+
+    /**
+     * Splits the text into the sections between added tokens and the added tokens themselves.
+     *
+     * @param string $text The text to split.
+     *
+     * @return array<array{0: string, 1: AddedToken|null}> The non-empty sections in order, each paired with
+     *  the added token it matched, or null for plain text.
+     */
+    public function split(string $text): array
+    {
+        if ($this->isEmpty() || $text === '') {
+            return [[$text, null]];
+        }
+
+        $candidates = $this->candidates($text);
+
+        if (empty($candidates)) {
+            return [[$text, null]];
+        }
+
+        $sections = [];
+        $cursor = 0;
+        $length = strlen($text);
+
+        foreach ($candidates as $start => $matches) {
+            if ($start < $cursor) {
+                continue;
+            }
+
+            $token = null;
+
+            // Longest first, so the first acceptable match is the leftmost-longest one
+            krsort($matches);
+
+            foreach ($matches as $end => $index) {
+                if (!$this->tokens[$index]->singleWord || $this->isSingleWord($text, $start, $end)) {
+                    $token = $this->tokens[$index];
+                    break;
+                }
+            }
+
+            if ($token === null) {
+                continue;
+            }
+
+            $from = $start;
+            $to = $end;
+
+            if ($token->lStrip) {
+                while ($from > $cursor && ctype_space($text[$from - 1])) {
+                    $from--;
+                }
+            }
+
+            if ($token->rStrip) {
+                while ($to < $length && ctype_space($text[$to])) {
+                    $to++;
+                }
+            }
+
+            if ($from > $cursor) {
+                $sections[] = [substr($text, $cursor, $from - $cursor), null];
+            }
+
+            $sections[] = [$token->content, $token];
+            $cursor = $to;
+        }
+
+        if ($cursor < $length) {
+            $sections[] = [substr($text, $cursor), null];
+        }
+
+        return $sections;
+    }
+
+    /**
+     * Runs the automaton over the text and collects every match.
+     *
+     * @return array<int, array<int, int>> Pattern indices keyed by start offset (ascending), then end offset.
+     */
+    protected function candidates(string $text): array
+    {
+        $transitions = $this->transitions;
+        $fail = $this->fail;
+        $outputs = $this->outputs;
+
+        $candidates = [];
+        $state = 0;
+        $length = strlen($text);
+
+        for ($i = 0; $i < $length; $i++) {
+            $byte = $text[$i];
+
+            while ($state !== 0 && !isset($transitions[$state][$byte])) {
+                $state = $fail[$state];
+            }
+
+            $state = $transitions[$state][$byte] ?? 0;
+
+            if (isset($outputs[$state])) {
+                foreach ($outputs[$state] as $index) {
+                    $start = $i + 1 - strlen($this->patterns[$index]);
+                    $candidates[$start][$i + 1] ??= $index;
+                }
+            }
+        }
+
+        ksort($candidates);
+
+        return $candidates;
+    }
+
+    /**
+     * Whether the match is not glued to word characters on either side.
+     */
+    protected function isSingleWord(string $text, int $start, int $end): bool
+    {
+        if ($start > 0) {
+            // Step back over UTF-8 continuation bytes to the start of the previous character
+            $prev = $start - 1;
+            while ($prev > 0 && (ord($text[$prev]) & 0xC0) === 0x80) {
+                $prev--;
+            }
+
+            if (preg_match('/^\w$/u', substr($text, $prev, $start - $prev))) {
+                return false;
+            }
+        }
+
+        if ($end < strlen($text)) {
+            $lead = ord($text[$end]);
+            $next = substr($text, $end, $lead < 0x80 ? 1 : ($lead < 0xE0 ? 2 : ($lead < 0xF0 ? 3 : 4)));
+
+            if (preg_match('/^\w$/u', $next)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
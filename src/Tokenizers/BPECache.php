@@ -0,0 +1,182 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Codewithkyrian\Transformers\Tokenizers;
+
+use Codewithkyrian\Transformers\Transformers;
+
+/**
+ * Bounded least-recently-used cache of BPE results.
+ *
+ * One cache is kept per namespace, so every BPE model with the same merges shares it within the process.
+ * When shared mode is enabled and APCu is available, results are also published to APCu so that other
+ * workers on the same host can reuse them.
+ */
+class BPECache
+{
+    /**
+     * Rough per-entry bookkeeping overhead, used to approximate the memory taken by an entry.
+     */
+    protected const ENTRY_OVERHEAD = 64;
+
+    /** @var array<string, static> */
+    protected static array $instances = [];
+
+    /** @var array<string, string[]> Cached results, from least to most recently used. */
+    protected array $entries = [];
+
+    protected int $bytes = 0;
+
+    public int $hits = 0;
+
+    public int $misses = 0;
+
+    public int $evictions = 0;
+
+    /**
+     * @param string $namespace Identifies the merges the cached results were produced with.
+     * @param int $maxEntries The maximum number of entries to keep. Zero disables the cache.
+     * @param int $maxBytes The approximate maximum memory taken by the entries. Zero means no limit.
+     * @param bool $shared Whether to also publish results to APCu.
+     */
+    public function __construct(
+        public readonly string $namespace,
+        public readonly int    $maxEntries = 65536,
+        public readonly int    $maxBytes = 0,
+        public readonly bool   $shared = false,
+    ) {}
+
+    /**
+     * Returns the process-wide cache for the given namespace, configured from the global Transformers settings.
+     */
+    public static function for(string $namespace): static
+    {
+        if (!isset(self::$instances[$namespace])) {
+            ['maxEntries' => $maxEntries, 'maxBytes' => $maxBytes, 'shared' => $shared] = Transformers::getBPECacheOptions();
+
+            $shared = $shared && function_exists('apcu_enabled') && apcu_enabled();
+
+            self::$instances[$namespace] = new static($namespace, $maxEntries, $maxBytes, $shared);
+        }
+
+        return self::$instances[$namespace];
+    }
+
+    /**
+     * Returns the hit, miss and eviction counters of every cache in the process, keyed by namespace.
+     *
+     * @return array<string, array{entries: int, bytes: int, hits: int, misses: int, evictions: int}>
+     */
+    public static function allStats(): array
+    {
+        return array_map(fn(self $cache) => $cache->stats(), self::$instances);
+    }
+
+    /**
+     * Looks up the BPE result for a token, marking it as recently used.
+     *
+     * @return string[]|null The cached result, or null on a miss.
+     */
+    public function get(string $token): ?array
+    {
+        if (isset($this->entries[$token])) {
+            $result = $this->entries[$token];
+
+            // Move the entry to the most recently used end
+            unset($this->entries[$token]);
+            $this->entries[$token] = $result;
+
+            ++$this->hits;
+
+            return $result;
+        }
+
+        if ($this->shared) {
+            $result = apcu_fetch($this->sharedKey($token), $success);
+
+            if ($success && is_array($result)) {
+                ++$this->hits;
+                $this->store($token, $result);
+
+                return $result;
+            }
+        }
+
+        ++$this->misses;
+
+        return null;
+    }
+
+    /**
+     * Stores the BPE result for a token, evicting the least recently used entries if the cache is full.
+     *
+     * @param string[] $result
+     */
+    public function set(string $token, array $result): void
+    {
+        $this->store($token, $result);
+
+        if ($this->shared) {
+            apcu_store($this->sharedKey($token), $result);
+        }
+    }
+
+    /**
+     * Removes every entry and resets the counters.
+     */
+    public function clear(): void
+    {
+        $this->entries = [];
+        $this->bytes = 0;
+        $this->hits = $this->misses = $this->evictions = 0;
+    }
+
+    /**
+     * @return array{entries: int, bytes: int, hits: int, misses: int, evictions: int}
+     */
+    public function stats(): array
+    {
+        return [
+            'entries' => count($this->entries),
+            'bytes' => $this->bytes,
+            'hits' => $this->hits,
+            'misses' => $this->misses,
+            'evictions' => $this->evictions,
+        ];
+    }
+
+    protected function store(string $token, array $result): void
+    {
+        if ($this->maxEntries <= 0) {
+            return;
+        }
+
+        if (isset($this->entries[$token])) {
+            $this->bytes -= self::entrySize($token, $this->entries[$token]);
+            unset($this->entries[$token]);
+        }
+
+        $this->entries[$token] = $result;
+        $this->bytes += self::entrySize($token, $result);
+
+        while (count($this->entries) > $this->maxEntries || ($this->maxBytes > 0 && $this->bytes > $this->maxBytes)) {
+            $oldest = (string)array_key_first($this->entries);
+
+            $this->bytes -= self::entrySize($oldest, $this->entries[$oldest]);
+            unset($this->entries[$oldest]);
+
+            ++$this->evictions;
+        }
+    }
+
+    protected static function entrySize(string $token, array $result): int
+    {
+        return strlen($token) + strlen(implode('', $result)) + self::ENTRY_OVERHEAD * (count($result) + 1);
+    }
+
+    protected function sharedKey(string $token): string
+    {
+        return "transformers-bpe:{$this->namespace}:{$token}";
+    }
+}
@@ -20,7 +20,9 @@ use SplPriorityQueue;
 class BPEModel extends TokenizerModel
 {
     /**
-     * Mapping of BPE merges to their rank.
+     * Mapping of BPE merges to their rank, keyed by the left then the right token of the pair.
+     *
+     * @var array<string, array<string, int>>
      */
     protected array $bpeRanks;
 
@@ -40,10 +42,19 @@ class BPEModel extends TokenizerModel
     protected bool $byteFallback;
 
     /**
-     * Cache of BPE encoded tokens.
-     *
+     * Whether words found in the vocabulary are emitted as-is, without applying merges.
+     */
+    protected bool $ignoreMerges;
+
+    /**
+     * Bounded cache of BPE encoded tokens, shared by every model with the same merges.
+     */
+    protected ?BPECache $cache = null;
+
+    /**
+     * Identifies the merges and options this model encodes with, used to namespace the cache.
      */
-    protected array $cache = [];
+    protected string $cacheNamespace;
 
 
     protected const BPE_SPLIT_TOKEN = ' ';
@@ -75,15 +86,49 @@ class BPEModel extends TokenizerModel
 
         $this->bpeRanks = [];
 
-        foreach ($this->merges as $i => $pair) {
-            $key = json_encode($pair);
-            $this->bpeRanks[$key] = $i;
+        foreach ($this->merges as $i => [$left, $right]) {
+            $this->bpeRanks[$left][$right] = $i;
         }
 
         $this->endOfWordSuffix = $config['end_of_word_suffix'] ?? null;
         $this->continuingSubwordSuffix = $config['continuing_subword_suffix'] ?? null;
 
         $this->byteFallback = $config['byte_fallback'] ?? false;
+        $this->ignoreMerges = $config['ignore_merges'] ?? false;
+
+        $this->cacheNamespace = hash('xxh128', serialize([
+            $this->merges,
+            $this->endOfWordSuffix,
+            $this->continuingSubwordSuffix,
+            $this->ignoreMerges ? array_keys($this->tokenToIds) : null,
+        ]));
+    }
+
+    /**
+     * Returns the cache of BPE encoded tokens for this model.
+     */
+    public function cache(): BPECache
+    {
+        return $this->cache ??= BPECache::for($this->cacheNamespace);
+    }
+
+    /**
+     * The cache is process-wide state, so it is left out of serialized models and looked up again on first use.
+     */
+    public function __serialize(): array
+    {
+        $state = get_object_vars($this);
+
+        unset($state['cache']);
+
+        return $state;
+    }
+
+    public function __unserialize(array $data): void
+    {
+        foreach ($data as $property => $value) {
+            $this->{$property} = $value;
+        }
     }
 
     /**
@@ -99,11 +144,18 @@ class BPEModel extends TokenizerModel
             return [];
         }
 
-        if (isset($this->cache[$token])) {
-            return $this->cache[$token];
+        $cache = $this->cache();
+
+        if (($cached = $cache->get($token)) !== null) {
+            return $cached;
+        }
+
+        if ($this->ignoreMerges && isset($this->tokenToIds[$token])) {
+            $cache->set($token, [$token]);
+            return [$token];
         }
 
-        $word = preg_split('//u', $token, -1, PREG_SPLIT_NO_EMPTY);
+        $word = mb_str_split($token);
 
         if ($this->endOfWordSuffix) {
             $word[count($word) - 1] .= $this->endOfWordSuffix;
@@ -204,7 +256,7 @@ class BPEModel extends TokenizerModel
         }
 
         // Save the result to the cache
-        $this->cache[$token] = $result;
+        $cache->set($token, $result);
 
         return $result;
     }
@@ -218,8 +270,7 @@ class BPEModel extends TokenizerModel
      */
     public function addNodeToQueue(SplPriorityQueue $queue, BPENode $node): void
     {
-        $pairKey = json_encode([$node->token, $node->next->token]);
-        $rank = $this->bpeRanks[$pairKey] ?? null;
+        $rank = $this->bpeRanks[$node->token][$node->next->token] ?? null;
 
         if ($rank !== null) {
             $node->score = - ($rank + $node->bias);
@@ -241,7 +292,7 @@ class BPEModel extends TokenizerModel
 
 
             foreach ($bpeTokenList as $bpeToken) {
-                if (array_key_exists($bpeToken, $this->tokenToIds)) {
+                if (isset($this->tokenToIds[$bpeToken])) {
                     $outputTokens[] = $bpeToken;
                 } else {
                     if ($this->byteFallback) {
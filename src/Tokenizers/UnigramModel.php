@@ -4,7 +4,7 @@ declare(strict_types=1);
 
 namespace Codewithkyrian\Transformers\Tokenizers;
 
-use Codewithkyrian\Transformers\DataStructures\CharTrie;
+use Codewithkyrian\Transformers\DataStructures\DoubleArray;
 use Codewithkyrian\Transformers\DataStructures\TokenLattice;
 use function Codewithkyrian\Transformers\Utils\array_pop_key;
 
@@ -25,7 +25,7 @@ class UnigramModel extends TokenizerModel
 
     protected float $unkScore = 0;
 
-    protected CharTrie $trie;
+    protected DoubleArray $trie;
 
 
     public function __construct(array $config, ...$args)
@@ -52,8 +52,7 @@ class UnigramModel extends TokenizerModel
         $this->unkScore = $this->minScore - 10.0;
 
         $this->scores[$this->unkTokenId] = $this->unkScore;
-        $this->trie = new CharTrie();
-        $this->trie->extend($this->vocab);
+        $this->trie = DoubleArray::build($this->tokenToIds);
 
         // NOTE: `fuse_unk` is hardcoded to true for Unigram models
         // See: https://github.com/huggingface/tokenizers/blob/b58227c7f1ccf8b73ee2268354336da56d91e492/tokenizers/src/models/unigram/model.rs#L119
@@ -61,25 +60,24 @@ class UnigramModel extends TokenizerModel
     }
 
     /**
-     * Populates lattice nodes.
+     * Populates lattice nodes in a single forward pass over the bytes of the sentence.
      * @param TokenLattice $lattice The token lattice to populate with nodes.
      */
     public function populateNodes(TokenLattice $lattice): void
     {
         $sentence = $lattice->sentence;
-        $len = mb_strlen($sentence);
+        $len = $lattice->len;
 
         $beginPos = 0;
 
         while ($beginPos < $len) {
-            $mblen = 1;
+            // Byte length of the UTF-8 character starting here, taken from its lead byte
+            $lead = ord($sentence[$beginPos]);
+            $mblen = min($len - $beginPos, $lead < 0x80 ? 1 : ($lead < 0xE0 ? 2 : ($lead < 0xF0 ? 3 : 4)));
             $hasSingleNode = false;
 
-            foreach ($this->trie->commonPrefixSearch(mb_substr($sentence, $beginPos)) as $token) {
-                $tokenId = $this->tokenToIds[$token];
-                $tokenScore = $this->scores[$tokenId];
-                $n = mb_strlen($token);
-                $lattice->insert($beginPos, $n, $tokenScore, $tokenId);
+            foreach ($this->trie->commonPrefixSearch($sentence, $beginPos) as $n => $tokenId) {
+                $lattice->insert($beginPos, $n, $this->scores[$tokenId], $tokenId);
                 if (!$hasSingleNode && $n === $mblen) {
                     $hasSingleNode = true;
                 }
@@ -113,8 +111,7 @@ class UnigramModel extends TokenizerModel
     {
         $toReturn = [];
         foreach ($tokens as $token) {
-            $tokenized = $this->tokenize($token);
-            $toReturn = array_merge($toReturn, $tokenized);
+            array_push($toReturn, ...$this->tokenize($token));
         }
         return $toReturn;
     }
@@ -14,6 +14,11 @@ class WordPieceModel extends TokenizerModel
 {
     protected int $maxInputCharsPerWord;
 
+    /**
+     * Byte length of the longest entry in the vocabulary, which bounds the candidate subwords tried.
+     */
+    protected int $maxTokenLength = 0;
+
     public function __construct(array $config)
     {
         parent::__construct($config);
@@ -26,6 +31,7 @@ class WordPieceModel extends TokenizerModel
 
         foreach ($this->tokenToIds as $token => $id) {
             $this->vocab[$id] = $token;
+            $this->maxTokenLength = max($this->maxTokenLength, strlen((string)$token));
         }
     }
 
@@ -38,10 +44,12 @@ class WordPieceModel extends TokenizerModel
     {
         $outputTokens = [];
 
+        $prefix = $this->config['continuing_subword_prefix'] ?? '';
+
         foreach ($tokens as $token) {
-            $chars = str_split($token);
+            $length = strlen($token);
 
-            if (count($chars) > $this->maxInputCharsPerWord) {
+            if ($length > $this->maxInputCharsPerWord) {
                 $outputTokens[] = $this->unkToken;
                 continue;
             }
@@ -50,18 +58,19 @@ class WordPieceModel extends TokenizerModel
             $start = 0;
             $subTokens = [];
 
-            while ($start < count($chars)) {
-                $end = count($chars);
+            while ($start < $length) {
+                // No vocabulary entry is longer than maxTokenLength, so don't try longer candidates.
+                $end = min($length, $start + $this->maxTokenLength);
                 $currentSubstring = null;
 
                 while ($start < $end) {
-                    $substr = implode('', array_slice($chars, $start, $end - $start));
+                    $substr = substr($token, $start, $end - $start);
 
                     if ($start > 0) {
-                        $substr = $this->config['continuing_subword_prefix'] . $substr;
+                        $substr = $prefix . $substr;
                     }
 
-                    if (array_key_exists($substr, $this->tokenToIds)) {
+                    if (isset($this->tokenToIds[$substr])) {
                         $currentSubstring = $substr;
                         break;
                     }
@@ -81,7 +90,7 @@ class WordPieceModel extends TokenizerModel
             if ($isUnknown) {
                 $outputTokens[] = $this->unkToken;
             } else {
-                $outputTokens = array_merge($outputTokens, $subTokens);
+                array_push($outputTokens, ...$subTokens);
             }
         }
 
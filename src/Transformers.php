@@ -5,6 +5,7 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers;
 
 use Codewithkyrian\Transformers\Utils\ImageDriver;
+use Codewithkyrian\Transformers\Utils\ResampleQuality;
 use Psr\Log\LoggerInterface;
 use RuntimeException;
 use Psr\Log\NullLogger;
@@ -25,6 +26,18 @@ class Transformers
 
     protected static ?LoggerInterface $logger = null;
 
+    protected static bool $tokenizerSnapshots = true;
+
+    protected static int $tokenizerWorkers = 1;
+
+    protected static array $bpeCacheOptions = ['maxEntries' => 65536, 'maxBytes' => 0, 'shared' => false];
+
+    protected static ResampleQuality $resampleQuality = ResampleQuality::SINC_FASTEST;
+
+    protected static int $audioWorkers = 1;
+
+    protected static int $imageWorkers = 1;
+
     /**
      * Returns a new instance of the static class.
      *
@@ -137,6 +150,98 @@ class Transformers
         return $this;
     }
 
+    /**
+     * Enable or disable compiled tokenizer snapshots. When enabled, a fully-built tokenizer is written next to its
+     * `tokenizer.json` in the cache directory and restored from there on the next load.
+     *
+     * @param bool $enabled
+     *
+     * @return $this
+     */
+    public function setTokenizerSnapshots(bool $enabled): static
+    {
+        self::$tokenizerSnapshots = $enabled;
+
+        return $this;
+    }
+
+    /**
+     * Configure the cache of BPE encoded words kept by BPE tokenizers. The cache is bounded and evicts the
+     * least recently used words once either limit is reached.
+     *
+     * @param int $maxEntries The maximum number of words to keep per tokenizer. Zero disables the cache.
+     * @param int $maxBytes The approximate maximum memory taken by the cached words. Zero means no limit.
+     * @param bool $shared Whether to also share cached words across workers through APCu, when it is available.
+     *
+     * @return $this
+     */
+    public function setBPECache(int $maxEntries = 65536, int $maxBytes = 0, bool $shared = false): static
+    {
+        self::$bpeCacheOptions = ['maxEntries' => $maxEntries, 'maxBytes' => $maxBytes, 'shared' => $shared];
+
+        return $this;
+    }
+
+    /**
+     * Set the number of worker processes used to encode large batches of texts. Batches are split across
+     * forked workers, so this requires the pcntl extension; without it, batches are encoded in-process.
+     *
+     * @param int $workers The maximum number of workers. One disables parallel encoding.
+     *
+     * @return $this
+     */
+    public function setTokenizerWorkers(int $workers): static
+    {
+        self::$tokenizerWorkers = max(1, $workers);
+
+        return $this;
+    }
+
+    /**
+     * Set the quality of the converter used to resample audio to the sample rate of the models.
+     *
+     * @param ResampleQuality $quality
+     *
+     * @return $this
+     */
+    public function setResampleQuality(ResampleQuality $quality): static
+    {
+        self::$resampleQuality = $quality;
+
+        return $this;
+    }
+
+    /**
+     * Set the number of worker processes used to decode batches of audio files. Batches are split across
+     * forked workers, so this requires the pcntl extension; without it, batches are decoded in-process.
+     *
+     * @param int $workers The maximum number of workers. One disables parallel decoding.
+     *
+     * @return $this
+     */
+    public function setAudioWorkers(int $workers): static
+    {
+        self::$audioWorkers = max(1, $workers);
+
+        return $this;
+    }
+
+    /**
+     * Set the number of worker processes used to decode and preprocess batches of images. Batches are split across
+     * forked workers, so this requires the pcntl extension; without it, or with the VIPS driver, whose thread pool
+     * does not survive a fork, batches are preprocessed in-process.
+     *
+     * @param int $workers The maximum number of workers. One disables parallel preprocessing.
+     *
+     * @return $this
+     */
+    public function setImageWorkers(int $workers): static
+    {
+        self::$imageWorkers = max(1, $workers);
+
+        return $this;
+    }
+
     public static function getCacheDir(): string
     {
         return self::$cacheDir;
@@ -171,6 +276,39 @@ class Transformers
         return self::$imageDriver;
     }
 
+    public static function useTokenizerSnapshots(): bool
+    {
+        return self::$tokenizerSnapshots;
+    }
+
+    public static function getTokenizerWorkers(): int
+    {
+        return self::$tokenizerWorkers;
+    }
+
+    public static function getResampleQuality(): ResampleQuality
+    {
+        return self::$resampleQuality;
+    }
+
+    public static function getAudioWorkers(): int
+    {
+        return self::$audioWorkers;
+    }
+
+    public static function getImageWorkers(): int
+    {
+        return self::$imageWorkers;
+    }
+
+    /**
+     * @return array{maxEntries: int, maxBytes: int, shared: bool}
+     */
+    public static function getBPECacheOptions(): array
+    {
+        return self::$bpeCacheOptions;
+    }
+
     public static function getLogger(): LoggerInterface
     {
         if (!isset(self::$logger)) {
@@ -5,11 +5,11 @@ declare(strict_types=1);
 
 namespace Codewithkyrian\Transformers\Utils;
 
-use Codewithkyrian\Transformers\FFI\TransformersUtils;
 use Codewithkyrian\Transformers\FFI\Samplerate;
 use Codewithkyrian\Transformers\FFI\Sndfile;
 use Codewithkyrian\Transformers\Tensor\Tensor;
 use FFI;
+use Generator;
 use InvalidArgumentException;
 use RuntimeException;
 use SplFixedArray;
@@ -18,30 +18,101 @@ use Psr\Log\LoggerInterface;
 
 class Audio
 {
+    /** The native libraries, loaded once and shared by every instance. */
+    protected static ?Sndfile $sharedSnd = null;
+    protected static ?Samplerate $sharedSrc = null;
+
+    /** @var array<string, array> Mel filter banks, keyed by their parameters. */
+    private static array $melFilterBanks = [];
+
+    /** @var array<string, Tensor> Mel filter banks as float32 tensors, keyed by their parameters. */
+    private static array $melFilterTensors = [];
+
+    /** @var array<string, Tensor> Window functions, keyed by their parameters. */
+    private static array $windows = [];
+
     protected Sndfile $snd;
     protected Samplerate $src;
 
     protected $sfinfo;
     protected $sndfile;
 
+    /** @var resource|null The PHP stream read through libsndfile's virtual I/O, if not reading from a path. */
+    protected $stream = null;
+
+    protected bool $ownsStream = false;
+
+    protected ?FFI\CData $virtualIo = null;
+
     protected LoggerInterface $logger;
 
-    public function __construct(string $filename)
+    /**
+     * @param string|resource $input The path of the audio file, or a readable PHP stream holding its contents.
+     *  Streams that cannot seek are spooled to a temporary stream first, since most formats need to seek.
+     */
+    public function __construct(mixed $input)
     {
         $this->logger = Transformers::getLogger();
-        $this->snd = new Sndfile();
-        $this->src = new Samplerate();
+        $this->snd = self::$sharedSnd ??= new Sndfile();
+        $this->src = self::$sharedSrc ??= new Samplerate();
 
         $this->sfinfo = $this->snd->new('SF_INFO');
-        $this->sndfile = $this->snd->open($filename, $this->snd->enum('SFM_READ'), FFI::addr($this->sfinfo));
-        $this->logger->info('Audio file loaded', [
-            'file' => $filename,
+
+        if (is_resource($input)) {
+            $this->sndfile = $this->openStream($input);
+        } else {
+            $this->sndfile = $this->snd->open($input, $this->snd->enum('SFM_READ'), FFI::addr($this->sfinfo));
+        }
+
+        $this->logger->debug('Audio file loaded', [
+            'file' => is_resource($input) ? 'stream' : $input,
             'samplerate' => $this->sfinfo->samplerate,
             'channels' => $this->sfinfo->channels,
             'frames' => $this->sfinfo->frames
         ]);
     }
 
+    /**
+     * Opens audio held in memory, e.g. the body of an upload.
+     *
+     * @param string $bytes The encoded audio file contents.
+     */
+    public static function fromBytes(string $bytes): static
+    {
+        $stream = fopen('php://temp', 'w+b');
+        fwrite($stream, $bytes);
+        rewind($stream);
+
+        $audio = new static($stream);
+        $audio->ownsStream = true;
+
+        return $audio;
+    }
+
+    /**
+     * Decodes several audio files into mono tensors at the given sample rate.
+     *
+     * When audio workers are configured, the file paths of the batch are split across forked worker processes that
+     * send their samples back over a socket pair. Streams and `Audio` instances are always decoded in-process.
+     *
+     * @param array<string|resource|Audio> $inputs
+     * @param int $samplerate The sample rate to resample to.
+     * @param ResampleQuality|null $quality The resampling quality. Defaults to the configured one.
+     *
+     * @return Tensor[] The 1D float32 samples of each input, in order.
+     */
+    public static function loadBatch(array $inputs, int $samplerate, ?ResampleQuality $quality = null): array
+    {
+        $inputs = array_values($inputs);
+
+        $load = fn($input) => ($input instanceof Audio ? $input : new Audio($input))->toTensor($samplerate, quality: $quality);
+
+        $onlyPaths = array_filter($inputs, 'is_string') === $inputs;
+        $workers = $onlyPaths ? Transformers::getAudioWorkers() : 1;
+
+        return forkMap($inputs, $workers, fn(array $chunk) => array_map($load, $chunk));
+    }
+
     public function channels(): int
     {
         return $this->sfinfo->channels;
@@ -62,67 +133,212 @@ class Audio
         return round($this->sfinfo->frames / $this->sfinfo->samplerate, 2);
     }
 
-    public function toTensor(int $samplerate = 41000, int $chunkSize = 2048): Tensor
+    /**
+     * Decodes, down-mixes and resamples the whole audio into a single mono tensor.
+     *
+     * The samples are written straight into a tensor sized from the number of frames in the file, which is only
+     * grown if the file reported fewer frames than it holds.
+     *
+     * @param int $samplerate The sample rate to resample to.
+     * @param int $chunkSize The number of input frames to decode at a time.
+     * @param ResampleQuality|null $quality The resampling quality. Defaults to the configured one.
+     */
+    public function toTensor(int $samplerate = 41000, int $chunkSize = 2048, ?ResampleQuality $quality = null): Tensor
     {
-        $tensorData = '';
-        $totalOutputFrames = 0;
+        $capacity = max(1, (int)ceil($this->frames() * $samplerate / $this->samplerate()) + 1);
+        $output = new Tensor(null, Tensor::float32, [$capacity]);
+        $length = 0;
+
+        foreach ($this->monoFrames($samplerate, $chunkSize, $quality) as [$samples, $frames]) {
+            if ($length + $frames > $capacity) {
+                $capacity = max(2 * $capacity, $length + $frames);
+                $grown = new Tensor(null, Tensor::float32, [$capacity]);
+                FFI::memcpy($grown->buffer()->addr(0), $output->buffer()->addr(0), $length * 4);
+                $output = $grown;
+            }
 
-        $state = $this->src->src_new($this->src->enum('SRC_SINC_FASTEST'), $this->channels());
-        $inputSize = $chunkSize * $this->channels();
-        $inputData = $this->src->new("float[$inputSize]");
-        $outputSize = $chunkSize * $this->channels();
-        $outputData = $this->src->new("float[$outputSize]");
+            FFI::memcpy($output->buffer()->addr($length), $samples, $frames * 4);
+            $length += $frames;
+        }
+
+        return $length === $capacity ? $output : new Tensor($output->buffer(), Tensor::float32, [$length], 0);
+    }
+
+    /**
+     * Decodes the audio incrementally, yielding resampled mono blocks as they become available.
+     *
+     * Only one block of decoded and resampled audio is held at a time, so memory stays bounded however long
+     * the input is. The audio is read from the start; it can only be streamed once per instance.
+     *
+     * @param int $samplerate The sample rate to resample to.
+     * @param int $blockSize The number of input frames to decode per block.
+     * @param ResampleQuality|null $quality The resampling quality. Defaults to the configured one.
+     *
+     * @return Generator<int, Tensor> 1D float32 tensors of samples.
+     */
+    public function stream(int $samplerate = 16000, int $blockSize = 16384, ?ResampleQuality $quality = null): Generator
+    {
+        foreach ($this->monoFrames($samplerate, $blockSize, $quality) as [$samples, $frames]) {
+            $block = new Tensor(null, Tensor::float32, [$frames]);
+            FFI::memcpy($block->buffer()->addr(0), $samples, $frames * 4);
+
+            yield $block;
+        }
+    }
+
+    /**
+     * Decodes, down-mixes and resamples the audio block by block, in that order, so the converter only ever
+     * processes a single channel.
+     *
+     * The yielded pointers refer to scratch buffers that are overwritten by the next block.
+     *
+     * @return Generator<int, array{0: FFI\CData, 1: int}> A pointer to the mono samples, and their number.
+     */
+    protected function monoFrames(int $samplerate, int $blockSize, ?ResampleQuality $quality = null): Generator
+    {
+        $channels = $this->channels();
+        $resample = $this->samplerate() !== $samplerate;
+        $ratio = $samplerate / $this->samplerate();
+
+        // Frames are decoded into a [blockSize, channels] tensor so the down-mix is a single matrix-vector product
+        $input = new Tensor(null, Tensor::float32, [$blockSize, $channels]);
+        $inputData = $input->buffer()->addr(0);
+
+        $mono = $channels > 1 ? new Tensor(null, Tensor::float32, [$blockSize]) : null;
+        $monoData = $mono?->buffer()->addr(0) ?? $inputData;
+
+        // Averaging the channels, scaled by sqrt(2) to keep the loudness of stereo recordings
+        $weights = Tensor::fill([$channels], sqrt(2) / $channels, Tensor::float32);
+
+        $downmix = function (int $frames) use ($channels, $input, $mono, $weights) {
+            if ($channels > 1) {
+                Tensor::mo()->la()->gemv(
+                    new Tensor($input->buffer(), Tensor::float32, [$frames, $channels], 0),
+                    $weights,
+                    1.0,
+                    0.0,
+                    new Tensor($mono->buffer(), Tensor::float32, [$frames], 0)
+                );
+            }
+        };
+
+        if (!$resample) {
+            do {
+                $frames = $this->snd->readf_float($this->sndfile, $inputData, $blockSize);
+
+                if ($frames > 0) {
+                    $downmix($frames);
+                    yield [$monoData, $frames];
+                }
+            } while ($frames === $blockSize);
+
+            return;
+        }
+
+        // Room for a whole block of input plus whatever the converter held back from the previous one
+        $outputFrames = (int)ceil($blockSize * $ratio) + 256;
+        $outputData = $this->src->new("float[$outputFrames]");
+
+        $quality ??= Transformers::getResampleQuality();
+        $state = $this->src->src_new($quality->value, 1);
 
         $srcData = $this->src->new('SRC_DATA');
-        $srcData->data_in = $this->src->cast('float *', $inputData);
-        $srcData->output_frames = $chunkSize / $this->channels();
         $srcData->data_out = $this->src->cast('float *', $outputData);
-        $srcData->src_ratio = $samplerate / $this->samplerate();
-
-        while (true) {
-            $srcData->input_frames = $this->snd->readf_float($this->sndfile, $inputData, $chunkSize);
-            if ($this->samplerate() === $samplerate) {
-                $strBuffer = FFI::string($inputData, $srcData->input_frames * $this->channels() * FFI::sizeof($inputData[0]));
-                $tensorData .= $strBuffer;
-                $totalOutputFrames += $srcData->input_frames;
-                if ($srcData->input_frames < $chunkSize) {
-                    break;
+        $srcData->output_frames = $outputFrames;
+        $srcData->src_ratio = $ratio;
+
+        try {
+            do {
+                $frames = $this->snd->readf_float($this->sndfile, $inputData, $blockSize);
+                $endOfInput = $frames < $blockSize;
+
+                if ($frames > 0) {
+                    $downmix($frames);
                 }
-                continue;
-            }
 
-            $this->logger->info('Resampling audio segment', [
-                'input_samplerate' => $this->samplerate(),
-                'output_samplerate' => $samplerate,
-                'input_frames' => $srcData->input_frames,
-                'output_frames' => $srcData->output_frames_gen
-            ]);
+                $srcData->data_in = $this->src->cast('float *', $monoData);
+                $srcData->input_frames = $frames;
+                $srcData->end_of_input = $endOfInput ? 1 : 0;
 
-            if ($srcData->input_frames < $chunkSize) {
-                $srcData->end_of_input = $this->snd->enum('SF_TRUE');
-            }
+                // Drain the converter until it consumed the whole block (and flushed its tail at the end)
+                while (true) {
+                    $this->src->process($state, FFI::addr($srcData));
 
-            $this->src->process($state, FFI::addr($srcData));
-            if ($srcData->end_of_input && $srcData->output_frames_gen === 0) {
-                break;
-            }
+                    if ($srcData->output_frames_gen > 0) {
+                        yield [$outputData, $srcData->output_frames_gen];
+                    }
 
-            $outputSize = $srcData->output_frames_gen * $this->channels() * FFI::sizeof($outputData[0]);
-            $strBuffer = FFI::string($outputData, $outputSize);
-            $tensorData .= $strBuffer;
-            $totalOutputFrames += $srcData->output_frames_gen;
+                    $used = $srcData->input_frames_used;
+                    $srcData->data_in += $used;
+                    $srcData->input_frames -= $used;
+
+                    if ($srcData->input_frames > 0) {
+                        continue;
+                    }
+
+                    if (!$endOfInput || $srcData->output_frames_gen === 0) {
+                        break;
+                    }
+                }
+            } while (!$endOfInput);
+        } finally {
+            $this->src->delete($state);
         }
+    }
 
-        $this->src->delete($state);
-        $audioTensor = Tensor::fromString($tensorData, Tensor::float32, [$totalOutputFrames, $this->channels()]);
+    /**
+     * Opens a PHP stream through libsndfile's virtual I/O.
+     *
+     * @param resource $stream
+     */
+    protected function openStream($stream): FFI\CData
+    {
+        if (!(stream_get_meta_data($stream)['seekable'] ?? false)) {
+            $spooled = fopen('php://temp', 'w+b');
+            stream_copy_to_stream($stream, $spooled);
+            rewind($spooled);
 
-        if ($this->channels() > 1) {
-            $this->logger->info('Averaging channels to mono', ['channels' => $this->channels()]);
-            $audioTensor = $audioTensor->mean(1)->multiply(sqrt(2));
+            $stream = $spooled;
+            $this->ownsStream = true;
         }
 
-        $this->logger->info('Audio tensor conversion complete', ['shape' => $audioTensor->shape()]);
-        return $audioTensor->squeeze();
+        $this->stream = $stream;
+
+        // libsndfile copies the callbacks; the struct is kept on the instance along with the closures it points to
+        $vio = $this->snd->new('SF_VIRTUAL_IO');
+
+        $vio->get_filelen = fn($userData) => fstat($this->stream)['size'] ?? -1;
+
+        $vio->seek = function ($offset, $whence, $userData) {
+            fseek($this->stream, $offset, $whence);
+            return ftell($this->stream);
+        };
+
+        $vio->read = function ($ptr, $count, $userData) {
+            $data = '';
+
+            while (strlen($data) < $count && !feof($this->stream)) {
+                $read = fread($this->stream, $count - strlen($data));
+                if ($read === false || $read === '') {
+                    break;
+                }
+                $data .= $read;
+            }
+
+            if ($data !== '') {
+                FFI::memcpy($ptr, $data, strlen($data));
+            }
+
+            return strlen($data);
+        };
+
+        $vio->write = fn($ptr, $count, $userData) => 0;
+
+        $vio->tell = fn($userData) => ftell($this->stream);
+
+        $this->virtualIo = $vio;
+
+        return $this->snd->openVirtual($vio, $this->snd->enum('SFM_READ'), FFI::addr($this->sfinfo));
     }
 
     public function fromTensor(Tensor $tensor): void
@@ -148,6 +364,10 @@ class Audio
     public function __destruct()
     {
         $this->snd->close($this->sndfile);
+
+        if ($this->ownsStream && is_resource($this->stream)) {
+            fclose($this->stream);
+        }
     }
 
     /**
@@ -176,6 +396,62 @@ class Audio
         ?string $norm = null,
         string  $melScale = "htk",
         bool    $triangularizeInMelSpace = false
+    ): array {
+        $key = implode('|', [$nFrequencyBins, $nMelFilters, $minFrequency, $maxFrequency, $samplingRate, $norm, $melScale, $triangularizeInMelSpace]);
+
+        return self::$melFilterBanks[$key] ??= self::createMelFilterBank(
+            $nFrequencyBins, $nMelFilters, $minFrequency, $maxFrequency, $samplingRate, $norm, $melScale, $triangularizeInMelSpace
+        );
+    }
+
+    /**
+     * Returns the same filter bank as `melFilterBank()` as a float32 tensor of shape (`num_mel_filters`, `width`),
+     * ready to be handed to the native spectrogram.
+     *
+     * The tensor is built once per set of parameters and shared by every caller, so it must not be modified in place.
+     *
+     * @param int|null $width The number of columns of the tensor, if wider than `nFrequencyBins`. The extra columns are zero.
+     */
+    public static function melFilterTensor(
+        int     $nFrequencyBins,
+        int     $nMelFilters,
+        float   $minFrequency,
+        float   $maxFrequency,
+        float   $samplingRate,
+        ?string $norm = null,
+        string  $melScale = "htk",
+        bool    $triangularizeInMelSpace = false,
+        ?int    $width = null
+    ): Tensor {
+        $width ??= $nFrequencyBins;
+        $key = implode('|', [$nFrequencyBins, $nMelFilters, $minFrequency, $maxFrequency, $samplingRate, $norm, $melScale, $triangularizeInMelSpace, $width]);
+
+        if (!isset(self::$melFilterTensors[$key])) {
+            $melFilters = self::melFilterBank(
+                $nFrequencyBins, $nMelFilters, $minFrequency, $maxFrequency, $samplingRate, $norm, $melScale, $triangularizeInMelSpace
+            );
+
+            $padding = array_fill(0, $width - $nFrequencyBins, 0.0);
+            $bytes = '';
+            foreach ($melFilters as $filter) {
+                $bytes .= pack('f*', ...$filter, ...$padding);
+            }
+
+            self::$melFilterTensors[$key] = Tensor::fromString($bytes, Tensor::float32, [$nMelFilters, $width]);
+        }
+
+        return self::$melFilterTensors[$key];
+    }
+
+    private static function createMelFilterBank(
+        int     $nFrequencyBins,
+        int     $nMelFilters,
+        float   $minFrequency,
+        float   $maxFrequency,
+        float   $samplingRate,
+        ?string $norm,
+        string  $melScale,
+        bool    $triangularizeInMelSpace
     ): array {
         if ($norm !== null && $norm !== "slaney") {
             throw new InvalidArgumentException('norm must be one of null or "slaney"');
@@ -196,17 +472,12 @@ class Audio
             $fftFreqs = self::linspace(0, floor($samplingRate / 2), $nFrequencyBins);
         }
 
-        $melFilters = self::createTriangularFilterBank($fftFreqs, $filterFreqs);
+        // Slaney-style mel is scaled to be approx constant energy per channel
+        $enorms = $norm === "slaney"
+            ? array_map(fn($i) => 2.0 / ($filterFreqs[$i + 2] - $filterFreqs[$i]), range(0, $nMelFilters - 1))
+            : null;
 
-        if ($norm === "slaney") {
-            // Slaney-style mel is scaled to be approx constant energy per channel
-            for ($i = 0; $i < $nMelFilters; ++$i) {
-                $enorm = 2.0 / ($filterFreqs[$i + 2] - $filterFreqs[$i]);
-                for ($j = 0; $j < $nFrequencyBins; ++$j) {
-                    $melFilters[$i][$j] *= $enorm;
-                }
-            }
-        }
+        $melFilters = self::createTriangularFilterBank($fftFreqs, $filterFreqs, $enorms);
 
         // TODO warn if there is a zero row
         return $melFilters;
@@ -220,38 +491,40 @@ class Audio
      *
      * @param float[] $fftFreqs Discrete frequencies of the FFT bins in Hz, of shape `(num_frequency_bins,)`.
      * @param float[] $filterFreqs Center frequencies of the triangular filters to create, in Hz, of shape `(num_mel_filters,)`.
+     * @param float[]|null $scales A factor to scale each filter by, e.g. for area normalization.
      *
      * @return array of shape `(num_frequency_bins, num_mel_filters)`.
      */
-    private static function createTriangularFilterBank(array $fftFreqs, array $filterFreqs): array
+    private static function createTriangularFilterBank(array $fftFreqs, array $filterFreqs, ?array $scales = null): array
     {
-        $filterDiff = [];
-        for ($i = 0; $i < count($filterFreqs) - 1; $i++) {
-            $filterDiff[$i] = $filterFreqs[$i + 1] - $filterFreqs[$i];
-        }
-
+        $numFreqs = count($filterFreqs) - 2;
+        $numBins = count($fftFreqs);
 
-        $slopes = [];
-        foreach ($fftFreqs as $freq) {
-            $slope = [];
-            foreach ($filterFreqs as $filterFreq) {
-                $slope[] = $filterFreq - $freq;
-            }
-            $slopes[] = $slope;
-        }
+        $ret = [];
 
+        for ($i = 0; $i < $numFreqs; $i++) {
+            $row = array_fill(0, $numBins, 0);
 
-        $numFreqs = count($filterFreqs) - 2;
+            $lower = $filterFreqs[$i];
+            $center = $filterFreqs[$i + 1];
+            $upper = $filterFreqs[$i + 2];
+            $scale = $scales[$i] ?? 1.0;
 
-        $ret = [];
+            // The FFT frequencies are increasing, so only the bins strictly inside the band can be non-zero
+            foreach ($fftFreqs as $j => $freq) {
+                if ($freq <= $lower) {
+                    continue;
+                }
+                if ($freq >= $upper) {
+                    break;
+                }
 
-        foreach ($fftFreqs as $j => $fft_freq) {
-            $slope = $slopes[$j];
-            for ($i = 0; $i < $numFreqs; $i++) {
-                $down = -$slope[$i] / $filterDiff[$i];
-                $up = $slope[$i + 2] / $filterDiff[$i + 1];
-                $ret[$i][$j] = max(0, min($down, $up));
+                $down = ($freq - $lower) / ($center - $lower);
+                $up = ($upper - $freq) / ($upper - $center);
+                $row[$j] = min($down, $up) * $scale;
             }
+
+            $ret[] = $row;
         }
 
         return $ret;
@@ -418,6 +691,9 @@ class Audio
      *  In this implementation, the window is assumed to be zero-padded to have the same size as the analysis frame.
      *  A padded window can be obtained from `windowFunction()`. The FFT input buffer may be larger than the analysis frame,
      *  typically the next power of two.
+     *
+     *  This builds a new `SpectrogramContext` on every call. When computing many spectrograms with the same
+     *  configuration, keep a context around and use it directly instead.
      */
     public static function spectrogram(
         Tensor  $waveform,
@@ -430,7 +706,7 @@ class Audio
         string  $padMode = 'reflect',
         bool    $onesided = true,
         float   $preemphasis = 0,
-        ?array  $melFilters = null,
+        Tensor|array|null $melFilters = null,
         float   $melFloor = 1e-10,
         ?string $logMel = null,
         float   $reference = 1.0,
@@ -441,92 +717,26 @@ class Audio
         bool    $doPad = true,
         bool    $transpose = false
     ): Tensor {
-        $transformersLib = new TransformersUtils();
-
-        $fftLength ??= $frameLength;
-        if ($frameLength > $fftLength) {
-            throw new InvalidArgumentException("frameLength ($frameLength) may not be larger than fftLength ($fftLength)");
-        }
-
-        $windowLength = $window->size();
-        if ($windowLength !== $frameLength) {
-            throw new InvalidArgumentException("Length of the window ($windowLength) must equal frameLength ($frameLength)");
-        }
-
-        if ($hopLength <= 0) {
-            throw new InvalidArgumentException("hopLength must be greater than zero");
-        }
-
-        if ($center) {
-            if ($padMode !== 'reflect') {
-                throw new InvalidArgumentException("pad_mode=\"{$padMode}\" not implemented yet.");
-            }
-
-            $halfWindow = (int)floor(($fftLength - 1) / 2) + 1;
-            $paddedLength = $waveform->size() + (2 * $halfWindow);
-
-            $padded = $transformersLib->padReflect(
-                $waveform->buffer()->addr($waveform->offset()),
-                $waveform->size(),
-                $paddedLength
-            );
-
-            $paddedStr = FFI::string($padded, FFI::sizeof($padded));
-
-            $waveform = Tensor::fromString($paddedStr, $waveform->dtype(), [$paddedLength]);
-        }
-
-        $numFrames = 1 + floor(($waveform->size() - $frameLength) / $hopLength);
-        $numFrequencyBins = $onesided ? floor($fftLength / 2) + 1 : $fftLength;
-
-        $d1 = (int)$numFrames;
-        $d1Max = (int)$numFrames;
-
-        if ($maxNumFrames !== null) {
-            if ($maxNumFrames > $numFrames) {
-                if ($doPad) {
-                    $d1Max = $maxNumFrames;
-                }
-            } else {
-                $d1Max = $d1 = $maxNumFrames;
-            }
-        }
-
-        $melFilters = Tensor::fromArray($melFilters, Tensor::float32);
-        $spectrogramShape = $transpose ? [$d1Max, $melFilters->count()] : [$melFilters->count(), $d1Max];
-        $logMel = match ($logMel) {
-            'log' => $transformersLib->enum('LOG_MEL_LOG'),
-            'log10' => $transformersLib->enum('LOG_MEL_LOG10'),
-            'dB' => $transformersLib->enum('LOG_MEL_DB'),
-            default => $transformersLib->enum('LOG_MEL_NONE'),
-        };
-
-        $spectrogram = $transformersLib->spectrogram(
-            $waveform->buffer()->addr($waveform->offset()),
-            $waveform->size(),
-            array_product($spectrogramShape),
+        $context = new SpectrogramContext(
+            $window,
+            $frameLength,
             $hopLength,
             $fftLength,
-            $window->buffer()->addr($window->offset()),
-            $windowLength,
-            $d1,
-            $d1Max,
             $power,
             $center,
+            $padMode,
+            $onesided,
             $preemphasis,
-            $melFilters->buffer()->addr($melFilters->offset()),
-            $melFilters->count(),
-            $numFrequencyBins,
+            $melFilters ?? [],
             $melFloor,
             $logMel,
             $removeDcOffset,
+            $maxNumFrames,
             $doPad,
-            $transpose,
+            $transpose
         );
 
-        $spectrogramStr = FFI::string($spectrogram, FFI::sizeof($spectrogram));
-
-        return Tensor::fromString($spectrogramStr, $waveform->dtype(), $spectrogramShape);
+        return $context->compute($waveform);
     }
 
     /**
@@ -548,13 +758,13 @@ class Audio
         $denominator = $M - 1;
         $factor = M_PI / $denominator;
 
-        $cosValues = Tensor::zeros([$M]);
+        $cosValues = [];
         for ($i = 0; $i < $M; ++$i) {
             $n = 2 * $i - $denominator;
-            $cosValues[$i] = 0.5 + 0.5 * cos($factor * $n);
+            $cosValues[] = 0.5 + 0.5 * cos($factor * $n);
         }
 
-        return $cosValues;
+        return Tensor::fromArray($cosValues);
     }
 
     /**
@@ -567,7 +777,8 @@ class Audio
      * Provide a value for `frame_length` if the window is smaller than the frame length, so that it will be zero-padded.
      * @param bool $center Whether to center the window inside the FFT buffer. Only used when `frameLength` is provided.
      *
-     * @return Tensor The window of shape `(windowLength)` or `(frameLength)`.
+     * @return Tensor The window of shape `(windowLength)` or `(frameLength)`. Windows are built once per set of
+     *  parameters and shared by every caller, so the returned tensor must not be modified in place.
      */
     public static function windowFunction(
         int    $windowLength,
@@ -576,7 +787,13 @@ class Audio
         ?int   $frameLength = null,
         bool   $center = true
     ): Tensor {
+        $key = implode('|', [$windowLength, $name, $periodic, $frameLength, $center]);
 
+        return self::$windows[$key] ??= self::createWindow($windowLength, $name, $periodic, $frameLength);
+    }
+
+    private static function createWindow(int $windowLength, string $name, bool $periodic, ?int $frameLength): Tensor
+    {
         $length = $periodic ? $windowLength + 1 : $windowLength;
 
         $window = match ($name) {
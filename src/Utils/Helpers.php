@@ -4,7 +4,9 @@ declare(strict_types=1);
 
 namespace Codewithkyrian\Transformers\Utils;
 
+use Closure;
 use Codewithkyrian\Transformers\Transformers;
+use Throwable;
 
 function memoryUsage(): string
 {
@@ -223,3 +225,91 @@ function isChineseChar(int $cp): bool
         || ($cp >= 0x2F800 && $cp <= 0x2FA1F)
     );
 }
+
+/**
+ * Maps a job over contiguous chunks of items, in forked worker processes when more than one worker is asked for
+ * and the pcntl extension is loaded. Each worker sends the serialized results of its chunk back over a socket pair.
+ * A chunk whose worker could not be started or did not finish is run in the current process instead.
+ *
+ * @param array $items The items to map.
+ * @param int $workers The maximum number of workers. One runs the job over all items in the current process.
+ * @param Closure $job Takes a chunk of items and the index of its first item, and returns one serializable result
+ *  per item, in order.
+ *
+ * @return array The results of every item, in order.
+ */
+function forkMap(array $items, int $workers, Closure $job): array
+{
+    $items = array_values($items);
+    $count = count($items);
+    $workers = min($workers, $count);
+
+    if ($workers < 2 || !function_exists('pcntl_fork')) {
+        return $count > 0 ? array_values($job($items, 0)) : [];
+    }
+
+    $chunkSize = (int)ceil($count / $workers);
+    $children = [];
+
+    for ($start = 0; $start < $count; $start += $chunkSize) {
+        $chunk = array_slice($items, $start, $chunkSize);
+        $sockets = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+        $pid = $sockets === false ? -1 : pcntl_fork();
+
+        if ($pid === 0) {
+            fclose($sockets[0]);
+
+            try {
+                $payload = serialize(array_values($job($chunk, $start)));
+            } catch (Throwable) {
+                $payload = '';
+            }
+
+            for ($written = 0; $written < strlen($payload); $written += $bytes) {
+                $bytes = fwrite($sockets[1], substr($payload, $written));
+                if (!$bytes) break;
+            }
+            fclose($sockets[1]);
+
+            // Leave without running the shutdown functions and destructors inherited from the parent
+            if (function_exists('posix_kill')) {
+                posix_kill(posix_getpid(), SIGKILL);
+            }
+            exit(0);
+        }
+
+        if ($pid > 0) {
+            fclose($sockets[1]);
+            $children[] = [$pid, $sockets[0], $start, $chunk];
+        } else {
+            if ($sockets !== false) {
+                fclose($sockets[0]);
+                fclose($sockets[1]);
+            }
+            $children[] = [null, null, $start, $chunk];
+        }
+    }
+
+    $results = [];
+
+    foreach ($children as [$pid, $socket, $start, $chunk]) {
+        $rows = null;
+
+        if ($pid !== null) {
+            $payload = stream_get_contents($socket);
+            fclose($socket);
+            pcntl_waitpid($pid, $status);
+
+            $rows = $payload ? @unserialize($payload) : null;
+        }
+
+        // The worker could not be started or did not finish, so its chunk is run here instead
+        if (!is_array($rows) || count($rows) !== count($chunk)) {
+            $rows = array_values($job($chunk, $start));
+        }
+
+        array_push($results, ...$rows);
+    }
+
+    return $results;
+}
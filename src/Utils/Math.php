@@ -65,20 +65,14 @@ class Math
 
     public static function getTopItems(array $items, int $topK = -1): array
     {
-        $indexedItems = [];
-        foreach ($items as $index => $value) {
-            $indexedItems[] = [$index, $value];
-        }
-
-        usort($indexedItems, function ($a, $b) {
-            return $b[1] <=> $a[1];
-        });
+        // arsort is stable and keeps the original indices as keys, so ties keep their input order.
+        arsort($items);
 
         if ($topK !== -1 && $topK > 0) {
-            $indexedItems = array_slice($indexedItems, 0, $topK);
+            $items = array_slice($items, 0, $topK, true);
         }
 
-        return $indexedItems;
+        return array_map(fn($index, $value) => [$index, $value], array_keys($items), $items);
     }
 
 
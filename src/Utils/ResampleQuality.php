@@ -0,0 +1,15 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Utils;
+
+// The converter types of libsamplerate: https://libsndfile.github.io/libsamplerate/api_misc.html#converters
+enum ResampleQuality: int
+{
+    case SINC_BEST = 0;
+    case SINC_MEDIUM = 1;
+    case SINC_FASTEST = 2;
+    case LINEAR = 4;
+}
@@ -0,0 +1,330 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Utils;
+
+use Codewithkyrian\Transformers\FFI\TransformersUtils;
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use FFI;
+use FFI\CData;
+use InvalidArgumentException;
+
+/**
+ * Holds everything a spectrogram configuration needs across calls: the loaded native library, the window and the
+ * flattened mel filters in native buffers, and scratch buffers for padding. Feature extractors keep one context
+ * for their configuration, so extracting features only costs the native STFT itself.
+ *
+ * Batches are written straight into a single output tensor, one row per waveform, without intermediate copies.
+ */
+class SpectrogramContext
+{
+    protected static ?TransformersUtils $library = null;
+
+    public readonly int $fftLength;
+
+    protected int $numFrequencyBins;
+
+    protected int $numMelFilters;
+
+    protected int $logMel;
+
+    protected Tensor $window;
+
+    protected Tensor $melFilters;
+
+    /** Scratch buffer holding the reflect-padded waveform. */
+    protected ?CData $padded = null;
+
+    protected int $paddedCapacity = 0;
+
+    /** Scratch buffer holding a zero-padded chunk. */
+    protected ?CData $chunk = null;
+
+    protected int $chunkCapacity = 0;
+
+    /**
+     * @param Tensor $window The window function, of length `frameLength`.
+     * @param int $frameLength The length of the analysis frames in samples.
+     * @param int $hopLength The number of samples between successive frames.
+     * @param int|null $fftLength The size of the FFT buffer in samples. Defaults to `frameLength`.
+     * @param float $power The exponent applied to the magnitude spectrogram.
+     * @param bool $center Whether to pad the waveform so that frame `t` is centered around time `t * hopLength`.
+     * @param string $padMode The padding mode used when `center` is true. Only `reflect` is supported.
+     * @param bool $onesided Whether to only keep the non-negative frequency bins.
+     * @param float $preemphasis The coefficient of the pre-emphasis filter applied to each frame.
+     * @param Tensor|array $melFilters The mel filter bank, one row per mel filter. Tensors, like the shared ones from
+     *  `Audio::melFilterTensor()`, are used as they are.
+     * @param float $melFloor The minimum value of the mel frequency bands.
+     * @param string|null $logMel How to convert the spectrogram to the log scale: `log`, `log10`, `dB` or null.
+     * @param bool|null $removeDcOffset Whether to subtract the mean of each frame before the FFT.
+     * @param int|null $maxNumFrames The number of frames to truncate, or pad to when `doPad` is true, the output to.
+     * @param bool $doPad Whether to pad the output up to `maxNumFrames`.
+     * @param bool $transpose Whether to return the spectrogram as `[frames, melFilters]` instead of `[melFilters, frames]`.
+     */
+    public function __construct(
+        Tensor                $window,
+        public readonly int   $frameLength,
+        public readonly int   $hopLength,
+        ?int                  $fftLength = null,
+        public readonly float $power = 1.0,
+        public readonly bool  $center = true,
+        string                $padMode = 'reflect',
+        bool                  $onesided = true,
+        public readonly float $preemphasis = 0,
+        Tensor|array          $melFilters = [],
+        public readonly float $melFloor = 1e-10,
+        ?string               $logMel = null,
+        public readonly ?bool $removeDcOffset = null,
+        public readonly ?int  $maxNumFrames = null,
+        public readonly bool  $doPad = true,
+        public readonly bool  $transpose = false
+    ) {
+        $this->fftLength = $fftLength ?? $frameLength;
+        if ($frameLength > $this->fftLength) {
+            throw new InvalidArgumentException("frameLength ($frameLength) may not be larger than fftLength ($this->fftLength)");
+        }
+
+        $windowLength = $window->size();
+        if ($windowLength !== $frameLength) {
+            throw new InvalidArgumentException("Length of the window ($windowLength) must equal frameLength ($frameLength)");
+        }
+
+        if ($hopLength <= 0) {
+            throw new InvalidArgumentException("hopLength must be greater than zero");
+        }
+
+        if ($center && $padMode !== 'reflect') {
+            throw new InvalidArgumentException("pad_mode=\"{$padMode}\" not implemented yet.");
+        }
+
+        if ($melFilters instanceof Tensor ? $melFilters->size() === 0 : empty($melFilters)) {
+            throw new InvalidArgumentException("melFilters must be provided");
+        }
+
+        $library = self::library();
+
+        $this->window = $window->dtype() === Tensor::float32 ? $window : $window->to(Tensor::float32);
+        $this->melFilters = match (true) {
+            !$melFilters instanceof Tensor => Tensor::fromArray($melFilters, Tensor::float32),
+            $melFilters->dtype() !== Tensor::float32 => $melFilters->to(Tensor::float32),
+            default => $melFilters,
+        };
+        $this->numMelFilters = $this->melFilters->shape()[0];
+        $this->numFrequencyBins = $onesided ? intdiv($this->fftLength, 2) + 1 : $this->fftLength;
+
+        $this->logMel = match ($logMel) {
+            'log' => $library->enum('LOG_MEL_LOG'),
+            'log10' => $library->enum('LOG_MEL_LOG10'),
+            'dB' => $library->enum('LOG_MEL_DB'),
+            default => $library->enum('LOG_MEL_NONE'),
+        };
+    }
+
+    /**
+     * Returns the native library, loading it on first use only.
+     */
+    public static function library(): TransformersUtils
+    {
+        return self::$library ??= new TransformersUtils();
+    }
+
+    /**
+     * The shape of the spectrogram of a waveform with the given number of samples.
+     *
+     * @return int[]
+     */
+    public function outputShape(int $waveformLength): array
+    {
+        [, $d1Max] = $this->numFrames($waveformLength);
+
+        return $this->transpose ? [$d1Max, $this->numMelFilters] : [$this->numMelFilters, $d1Max];
+    }
+
+    /**
+     * Computes the spectrogram of one waveform.
+     */
+    public function compute(Tensor $waveform): Tensor
+    {
+        $waveform = $this->asFloat32($waveform);
+        $shape = $this->outputShape($waveform->size());
+
+        $output = new Tensor(null, Tensor::float32, $shape);
+
+        $this->computeInto(
+            $waveform->buffer()->addr($waveform->offset()),
+            $waveform->size(),
+            $output->buffer()->addr(0)
+        );
+
+        return $output;
+    }
+
+    /**
+     * Computes the spectrograms of several waveforms into a single `[N, ...]` tensor.
+     *
+     * Every waveform must produce a spectrogram of the same shape, either because they have the same length or
+     * because `maxNumFrames` is set with `doPad`.
+     *
+     * @param Tensor[] $waveforms
+     */
+    public function computeBatch(array $waveforms): Tensor
+    {
+        if (empty($waveforms)) {
+            throw new InvalidArgumentException("computeBatch expects at least one waveform");
+        }
+
+        $waveforms = array_map(fn(Tensor $waveform) => $this->asFloat32($waveform), array_values($waveforms));
+
+        $shape = $this->outputShape($waveforms[0]->size());
+        $itemSize = array_product($shape);
+
+        foreach ($waveforms as $waveform) {
+            if ($this->outputShape($waveform->size()) !== $shape) {
+                throw new InvalidArgumentException("All waveforms in a batch must produce spectrograms of the same shape");
+            }
+        }
+
+        $output = new Tensor(null, Tensor::float32, [count($waveforms), ...$shape]);
+
+        foreach ($waveforms as $i => $waveform) {
+            $this->computeInto(
+                $waveform->buffer()->addr($waveform->offset()),
+                $waveform->size(),
+                $output->buffer()->addr($i * $itemSize)
+            );
+        }
+
+        return $output;
+    }
+
+    /**
+     * Computes the spectrograms of fixed-length chunks of one waveform into a single `[N, ...]` tensor.
+     *
+     * Chunks running past the end of the waveform are zero-padded to `chunkLength`, so every chunk produces a
+     * spectrogram of the same shape.
+     *
+     * @param Tensor $waveform The 1D waveform.
+     * @param int[] $offsets The sample offset of each chunk.
+     * @param int $chunkLength The length of each chunk in samples.
+     */
+    public function computeChunks(Tensor $waveform, array $offsets, int $chunkLength): Tensor
+    {
+        if (empty($offsets)) {
+            throw new InvalidArgumentException("computeChunks expects at least one offset");
+        }
+
+        $waveform = $this->asFloat32($waveform);
+        $samples = $waveform->buffer()->addr($waveform->offset());
+        $length = $waveform->size();
+
+        $shape = $this->outputShape($chunkLength);
+        $itemSize = array_product($shape);
+
+        $output = new Tensor(null, Tensor::float32, [count($offsets), ...$shape]);
+
+        if ($this->chunkCapacity < $chunkLength) {
+            $this->chunk = self::library()->new("float[$chunkLength]");
+            $this->chunkCapacity = $chunkLength;
+        }
+
+        foreach (array_values($offsets) as $i => $offset) {
+            if ($offset < 0 || $offset >= $length) {
+                throw new InvalidArgumentException("Chunk offset $offset is out of range for a waveform of $length samples");
+            }
+
+            $available = min($chunkLength, $length - $offset);
+
+            if ($available === $chunkLength) {
+                $chunk = $samples + $offset;
+            } else {
+                FFI::memset($this->chunk, 0, $chunkLength * 4);
+                FFI::memcpy($this->chunk, $samples + $offset, $available * 4);
+                $chunk = $this->chunk;
+            }
+
+            $this->computeInto($chunk, $chunkLength, $output->buffer()->addr($i * $itemSize));
+        }
+
+        return $output;
+    }
+
+    /**
+     * @return array{0: int, 1: int} The number of computed frames, and the number of frames in the output.
+     */
+    protected function numFrames(int $waveformLength): array
+    {
+        if ($this->center) {
+            $waveformLength += 2 * (intdiv($this->fftLength - 1, 2) + 1);
+        }
+
+        $numFrames = 1 + (int)floor(($waveformLength - $this->frameLength) / $this->hopLength);
+
+        $d1 = $d1Max = $numFrames;
+
+        if ($this->maxNumFrames !== null) {
+            if ($this->maxNumFrames > $numFrames) {
+                if ($this->doPad) {
+                    $d1Max = $this->maxNumFrames;
+                }
+            } else {
+                $d1Max = $d1 = $this->maxNumFrames;
+            }
+        }
+
+        return [$d1, $d1Max];
+    }
+
+    /**
+     * Runs the native STFT over `$length` samples, writing the spectrogram to `$output`.
+     */
+    protected function computeInto(CData $samples, int $length, CData $output): void
+    {
+        $library = self::library();
+        [$d1, $d1Max] = $this->numFrames($length);
+
+        if ($this->center) {
+            $paddedLength = $length + 2 * (intdiv($this->fftLength - 1, 2) + 1);
+
+            if ($this->paddedCapacity < $paddedLength) {
+                $this->padded = $library->new("float[$paddedLength]");
+                $this->paddedCapacity = $paddedLength;
+            }
+
+            $library->padReflect($samples, $length, $paddedLength, $this->padded);
+
+            $samples = $this->padded;
+            $length = $paddedLength;
+        }
+
+        $library->spectrogram(
+            $samples,
+            $length,
+            $d1Max * $this->numMelFilters,
+            $this->hopLength,
+            $this->fftLength,
+            $this->window->buffer()->addr($this->window->offset()),
+            $this->window->size(),
+            $d1,
+            $d1Max,
+            $this->power,
+            $this->center,
+            $this->preemphasis,
+            $this->melFilters->buffer()->addr($this->melFilters->offset()),
+            $this->numMelFilters,
+            $this->numFrequencyBins,
+            $this->melFloor,
+            $this->logMel,
+            $this->removeDcOffset,
+            $this->doPad,
+            $this->transpose,
+            $output,
+        );
+    }
+
+    protected function asFloat32(Tensor $waveform): Tensor
+    {
+        return $waveform->dtype() === Tensor::float32 ? $waveform : $waveform->to(Tensor::float32);
+    }
+}
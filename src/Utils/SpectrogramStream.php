@@ -0,0 +1,167 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Utils;
+
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use FFI;
+use InvalidArgumentException;
+
+/**
+ * Computes spectrogram frames incrementally as samples are pushed, so features can be extracted while the
+ * audio is still being decoded or recorded.
+ *
+ * Only the samples not yet covered by a whole frame are kept between pushes. When centering, the start and
+ * end of the signal are reflect-padded exactly like the offline centered STFT, so the concatenated frames
+ * match `SpectrogramContext::compute()` over the whole signal.
+ */
+class SpectrogramStream
+{
+    /** Samples not yet covered by a whole frame. */
+    protected ?Tensor $pending = null;
+
+    /** The last samples pushed, kept to reflect-pad the end of the signal. */
+    protected ?Tensor $tail = null;
+
+    protected bool $started = false;
+
+    protected bool $finished = false;
+
+    protected int $padLength;
+
+    /**
+     * @param SpectrogramContext $context A context computing uncentered frames without `maxNumFrames`.
+     * @param bool $center Whether to reflect-pad the start and end of the signal by half the FFT length.
+     */
+    public function __construct(protected SpectrogramContext $context, protected bool $center = true)
+    {
+        if ($context->center || $context->maxNumFrames !== null) {
+            throw new InvalidArgumentException("Streaming spectrograms need a context without centering and maxNumFrames");
+        }
+
+        $this->padLength = intdiv($context->fftLength - 1, 2) + 1;
+    }
+
+    /**
+     * Adds samples to the stream.
+     *
+     * @param Tensor $samples 1D float32 samples.
+     *
+     * @return Tensor|null The frames completed by these samples, or null if none were.
+     */
+    public function push(Tensor $samples): ?Tensor
+    {
+        if ($this->finished) {
+            throw new InvalidArgumentException("Cannot push samples to a finished spectrogram stream");
+        }
+
+        if ($samples->size() === 0) {
+            return null;
+        }
+
+        if ($samples->dtype() !== Tensor::float32) {
+            $samples = $samples->to(Tensor::float32);
+        }
+
+        $this->pending = $this->pending === null ? $samples : Tensor::concat([$this->pending, $samples]);
+
+        if ($this->center) {
+            $this->tail = self::lastSamples($this->tail === null ? $samples : Tensor::concat([$this->tail, $samples]), $this->padLength + 1);
+
+            // The left reflection needs the first padLength + 1 samples of the signal
+            if (!$this->started) {
+                if ($this->pending->size() <= $this->padLength) {
+                    return null;
+                }
+
+                $this->pending = Tensor::concat([$this->reflect($this->pending, true), $this->pending]);
+                $this->started = true;
+            }
+        }
+
+        return $this->drain();
+    }
+
+    /**
+     * Ends the stream, padding the end of the signal when centering.
+     *
+     * @return Tensor|null The remaining frames, or null if there are none.
+     */
+    public function finish(): ?Tensor
+    {
+        if ($this->finished || $this->pending === null) {
+            $this->finished = true;
+            return null;
+        }
+
+        $this->finished = true;
+
+        if ($this->center) {
+            if (!$this->started) {
+                // Too short to have been started: pad the whole signal at once
+                $this->pending = Tensor::concat([
+                    $this->reflect($this->pending, true),
+                    $this->pending,
+                    $this->reflect($this->pending, false),
+                ]);
+            } else {
+                $this->pending = Tensor::concat([$this->pending, $this->reflect($this->tail, false)]);
+            }
+        }
+
+        return $this->drain();
+    }
+
+    /**
+     * Computes every whole frame in the pending samples and keeps the rest for the next push.
+     */
+    protected function drain(): ?Tensor
+    {
+        $frameLength = $this->context->frameLength;
+        $hopLength = $this->context->hopLength;
+        $available = $this->pending->size();
+
+        if ($available < $frameLength) {
+            return null;
+        }
+
+        $numFrames = 1 + intdiv($available - $frameLength, $hopLength);
+        $used = ($numFrames - 1) * $hopLength + $frameLength;
+
+        $frames = $this->context->compute($this->pending->sliceWithBounds([0], [$used]));
+
+        $consumed = $numFrames * $hopLength;
+        $this->pending = $consumed < $available
+            ? $this->pending->sliceWithBounds([$consumed], [$available - $consumed])
+            : null;
+
+        return $frames;
+    }
+
+    /**
+     * Returns the reflection padding the native STFT would add before (or after) these samples.
+     */
+    protected function reflect(Tensor $samples, bool $left): Tensor
+    {
+        $count = min($samples->size(), $this->padLength + 1);
+        $edge = $left ? $samples->sliceWithBounds([0], [$count]) : self::lastSamples($samples, $count);
+
+        $paddedLength = $count + 2 * $this->padLength;
+        $library = SpectrogramContext::library();
+        $padded = $library->padReflect($edge->buffer()->addr($edge->offset()), $count, $paddedLength);
+
+        $start = $library->cast('float *', $padded) + ($left ? 0 : $count + $this->padLength);
+        $padding = FFI::string($start, $this->padLength * 4);
+
+        return Tensor::fromString($padding, Tensor::float32, [$this->padLength]);
+    }
+
+    protected static function lastSamples(Tensor $samples, int $count): Tensor
+    {
+        $size = $samples->size();
+
+        return $size <= $count ? $samples : $samples->sliceWithBounds([$size - $count], [$count]);
+    }
+}
@@ -0,0 +1,218 @@
+<?php
+
+declare(strict_types=1);
+
+
+namespace Codewithkyrian\Transformers\Utils;
+
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use InvalidArgumentException;
+
+/**
+ * Splits audio on silence into voiced segments, so that only speech is sent to a speech recognition model.
+ *
+ * Each frame is classified from two features of its log-mel spectrogram, computed natively like the spectrogram
+ * of the feature extractors:
+ *   - its energy, the mean of its log-mel bands, compared to the noise floor of the audio, and
+ *   - its spectral flux, the mean increase of its log-mel bands over the previous frame, which catches soft onsets.
+ *
+ * Short pauses are bridged, short bursts dropped, and the resulting segments padded a little and cut at their
+ * quietest frame when longer than the model can take at once.
+ */
+class VoiceActivityDetector
+{
+    protected SpectrogramContext $context;
+
+    /**
+     * @param int $samplingRate The sample rate of the audio.
+     * @param float $energyThreshold How far above the noise floor, in log10 units (10 dB each), a frame must be to be voiced.
+     * @param float $fluxThreshold The spectral flux, in log10 units, above which a frame at half the energy threshold is voiced.
+     * @param float $minSilenceSecs Pauses shorter than this are kept inside their segment.
+     * @param float $minSpeechSecs Voiced runs shorter than this are dropped.
+     * @param float $padSecs The audio kept before and after each segment.
+     * @param SpectrogramContext|null $context The uncentered, transposed log-mel spectrogram to compute the features
+     *  from. Defaults to 25ms frames every 10ms over 40 mel bands.
+     */
+    public function __construct(
+        protected int   $samplingRate = 16000,
+        protected float $energyThreshold = 1.0,
+        protected float $fluxThreshold = 0.3,
+        protected float $minSilenceSecs = 0.5,
+        protected float $minSpeechSecs = 0.25,
+        protected float $padSecs = 0.2,
+        ?SpectrogramContext $context = null,
+    ) {
+        if ($context !== null && ($context->center || !$context->transpose)) {
+            throw new InvalidArgumentException("Voice activity detection needs an uncentered and transposed spectrogram context");
+        }
+
+        $frameLength = (int)round(0.025 * $samplingRate);
+
+        $this->context = $context ?? new SpectrogramContext(
+            Audio::windowFunction($frameLength, 'hann', false),
+            frameLength: $frameLength,
+            hopLength: (int)round(0.01 * $samplingRate),
+            power: 2.0,
+            center: false,
+            melFilters: Audio::melFilterTensor(intdiv($frameLength, 2) + 1, 40, 0, $samplingRate / 2, $samplingRate, 'slaney', 'slaney'),
+            logMel: 'log10',
+            transpose: true,
+        );
+    }
+
+    /**
+     * Finds the voiced segments of the audio.
+     *
+     * @param Tensor $waveform The 1D waveform.
+     * @param int|null $maxLength The maximum length of a segment in samples. Longer segments are split.
+     *
+     * @return array<array{0: int, 1: int}> The start and end sample of each segment, in order.
+     */
+    public function segments(Tensor $waveform, ?int $maxLength = null): array
+    {
+        $length = $waveform->size();
+        $frameLength = $this->context->frameLength;
+        $hopLength = $this->context->hopLength;
+
+        if ($length < $frameLength) {
+            return $length > 0 ? [[0, $length]] : [];
+        }
+
+        $spectrogram = $this->context->compute($waveform);
+        [$numFrames, $numBands] = $spectrogram->shape();
+
+        $energy = $spectrogram->sum(1)->multiply(1.0 / $numBands)->toArray();
+        $flux = $this->flux($spectrogram, $numFrames, $numBands);
+
+        $sorted = $energy;
+        sort($sorted);
+        $floor = $sorted[(int)floor(0.1 * ($numFrames - 1))];
+
+        $voiced = [];
+        foreach ($energy as $t => $value) {
+            $voiced[$t] = $value > $floor + $this->energyThreshold
+                || ($flux[$t] > $this->fluxThreshold && $value > $floor + $this->energyThreshold / 2);
+        }
+
+        $runs = $this->runs($voiced, $hopLength);
+
+        $segments = [];
+        $pad = (int)round($this->padSecs * $this->samplingRate);
+
+        foreach ($runs as [$startFrame, $endFrame]) {
+            $start = max(0, $startFrame * $hopLength - $pad);
+            $end = min($length, $endFrame * $hopLength + $frameLength + $pad);
+
+            // Padding can make neighbouring segments overlap
+            if (!empty($segments) && $start <= $segments[count($segments) - 1][1]) {
+                $segments[count($segments) - 1][1] = $end;
+            } else {
+                $segments[] = [$start, $end];
+            }
+        }
+
+        if ($maxLength === null) {
+            return $segments;
+        }
+
+        $split = [];
+        foreach ($segments as [$start, $end]) {
+            array_push($split, ...$this->split($start, $end, $maxLength, $energy, $hopLength));
+        }
+
+        return $split;
+    }
+
+    /**
+     * The mean positive change of each frame's log-mel bands over the previous frame.
+     *
+     * @return float[]
+     */
+    protected function flux(Tensor $spectrogram, int $numFrames, int $numBands): array
+    {
+        if ($numFrames < 2) {
+            return array_fill(0, $numFrames, 0.0);
+        }
+
+        $current = $spectrogram->sliceWithBounds([1, 0], [$numFrames - 1, $numBands]);
+        $previous = $spectrogram->sliceWithBounds([0, 0], [$numFrames - 1, $numBands]);
+
+        $increase = $current->add($previous->multiply(-1.0))->maximum(0.0);
+
+        return [0.0, ...$increase->sum(1)->multiply(1.0 / $numBands)->toArray()];
+    }
+
+    /**
+     * Turns the voiced frames into runs, bridging short pauses and dropping short bursts.
+     *
+     * @param bool[] $voiced
+     * @return array<array{0: int, 1: int}> The first and last frame of each run.
+     */
+    protected function runs(array $voiced, int $hopLength): array
+    {
+        $minSilence = (int)ceil($this->minSilenceSecs * $this->samplingRate / $hopLength);
+        $minSpeech = (int)ceil($this->minSpeechSecs * $this->samplingRate / $hopLength);
+
+        $runs = [];
+        $start = null;
+
+        foreach ($voiced as $t => $isVoiced) {
+            if ($isVoiced && $start === null) {
+                $start = $t;
+            } elseif (!$isVoiced && $start !== null) {
+                $runs[] = [$start, $t - 1];
+                $start = null;
+            }
+        }
+
+        if ($start !== null) {
+            $runs[] = [$start, count($voiced) - 1];
+        }
+
+        $bridged = [];
+        foreach ($runs as $run) {
+            if (!empty($bridged) && $run[0] - $bridged[count($bridged) - 1][1] - 1 < $minSilence) {
+                $bridged[count($bridged) - 1][1] = $run[1];
+            } else {
+                $bridged[] = $run;
+            }
+        }
+
+        return array_values(array_filter($bridged, fn($run) => $run[1] - $run[0] + 1 >= $minSpeech));
+    }
+
+    /**
+     * Splits a segment longer than `$maxLength` samples at its quietest frames.
+     *
+     * @return array<array{0: int, 1: int}>
+     */
+    protected function split(int $start, int $end, int $maxLength, array $energy, int $hopLength): array
+    {
+        $segments = [];
+
+        while ($end - $start > $maxLength) {
+            // Cut in the last third of the allowed length, where the energy is the lowest
+            $firstFrame = intdiv($start + intdiv(2 * $maxLength, 3), $hopLength);
+            $lastFrame = min(count($energy) - 1, intdiv($start + $maxLength, $hopLength) - 1);
+
+            $cut = $start + $maxLength;
+            $lowest = INF;
+
+            for ($t = $firstFrame; $t <= $lastFrame; $t++) {
+                if ($energy[$t] < $lowest) {
+                    $lowest = $energy[$t];
+                    $cut = $t * $hopLength;
+                }
+            }
+
+            $cut = max($start + 1, min($cut, $start + $maxLength));
+
+            $segments[] = [$start, $cut];
+            $start = $cut;
+        }
+
+        $segments[] = [$start, $end];
+
+        return $segments;
+    }
+}
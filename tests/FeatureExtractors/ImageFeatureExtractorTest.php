@@ -0,0 +1,105 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\FeatureExtractors\ImageFeatureExtractor;
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use Codewithkyrian\Transformers\Transformers;
+use Codewithkyrian\Transformers\Utils\Image;
+use Codewithkyrian\Transformers\Utils\ImageDriver;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+
+    // A 3 x 2 x 2 image with pixel values from 0 to 255
+    $this->pixels = array_map(fn($c) => [[$c * 80, $c * 80 + 5], [$c * 80 + 10, 255 - $c]], range(0, 2));
+
+    $this->rescaleAndNormalize = fn(ImageFeatureExtractor $extractor, Tensor $image, bool $doNormalize) => (fn() => $this->rescaleAndNormalize($image, $doNormalize))->call($extractor);
+
+    // The result of rescaling, subtracting the mean and dividing by the std one after the other
+    $this->expected = fn(array $mean, array $std) => array_map(
+        fn($plane, $c) => array_map(fn($row) => array_map(fn($x) => ($x / 255 - $mean[$c]) / $std[$c], $row), $plane),
+        $this->pixels,
+        array_keys($this->pixels)
+    );
+});
+
+it('rescales without normalizing', function () {
+    $extractor = new ImageFeatureExtractor(['do_normalize' => false]);
+    $image = new Tensor($this->pixels, Tensor::float32);
+
+    ($this->rescaleAndNormalize)($extractor, $image, false);
+
+    expect($image->toArray())->toEqualWithDelta(($this->expected)([0, 0, 0], [1, 1, 1]), 1e-6);
+});
+
+it('normalizes with a scalar mean and std', function () {
+    $extractor = new ImageFeatureExtractor(['image_mean' => 0.5, 'image_std' => 0.5]);
+    $image = new Tensor($this->pixels, Tensor::float32);
+
+    ($this->rescaleAndNormalize)($extractor, $image, true);
+
+    expect($image->toArray())->toEqualWithDelta(($this->expected)([0.5, 0.5, 0.5], [0.5, 0.5, 0.5]), 1e-5);
+});
+
+it('normalizes each channel of an image in its slot of a batch', function () {
+    $mean = [0.485, 0.456, 0.406];
+    $std = [0.229, 0.224, 0.225];
+
+    $extractor = new ImageFeatureExtractor(['image_mean' => $mean, 'image_std' => $std]);
+    $batch = new Tensor([$this->pixels, $this->pixels], Tensor::float32);
+
+    ($this->rescaleAndNormalize)($extractor, $batch[1], true);
+
+    expect($batch[0]->toArray())->toBe((new Tensor($this->pixels, Tensor::float32))->toArray())
+        ->and($batch[1]->toArray())->toEqualWithDelta(($this->expected)($mean, $std), 1e-5);
+});
+
+it('throws when the mean and std do not match the channels', function () {
+    $extractor = new ImageFeatureExtractor(['image_mean' => [0.5, 0.5], 'image_std' => [0.5, 0.5]]);
+
+    ($this->rescaleAndNormalize)($extractor, new Tensor($this->pixels, Tensor::float32), true);
+})->throws(Exception::class, 'must match the number of channels');
+
+describe('batches', function () {
+    beforeEach(function () {
+        if (!extension_loaded('gd')) {
+            $this->markTestSkipped('GD extension is not loaded.');
+        }
+
+        // VIPS batches are always preprocessed in-process
+        Transformers::setup()->setImageDriver(ImageDriver::GD);
+        Image::setDriver(ImageDriver::GD);
+    });
+
+    afterEach(function () {
+        Transformers::setup()->setImageDriver(ImageDriver::VIPS)->setImageWorkers(1);
+        Image::setDriver(ImageDriver::VIPS);
+    });
+
+    it('preprocesses a batch the same with worker processes', function () {
+        $extractor = new ImageFeatureExtractor([
+            'do_resize' => true,
+            'size' => ['height' => 32, 'width' => 32],
+            'image_mean' => 0.5,
+            'image_std' => 0.5,
+            'do_normalize' => true,
+        ]);
+
+        $sample = Image::read('tests/fixtures/images/sample.jpg');
+        $images = [$sample, $sample->resize(64, 48), $sample->resize(40, 40)];
+
+        $serial = $extractor($images);
+
+        Transformers::setup()->setImageWorkers(2);
+        $parallel = $extractor($images);
+
+        expect($parallel['pixel_values']->shape())->toBe([3, 3, 32, 32])
+            ->and($parallel['pixel_values']->toArray())->toBe($serial['pixel_values']->toArray())
+            ->and($parallel['original_sizes'])->toBe($serial['original_sizes'])
+            ->and($parallel['original_sizes'][1])->toBe([64, 48])
+            ->and($parallel['reshaped_input_sizes'])->toBe($serial['reshaped_input_sizes']);
+    });
+});
@@ -0,0 +1,42 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\FeatureExtractors\Wav2Vec2FeatureExtractor;
+use Codewithkyrian\Transformers\Tensor\Tensor;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+});
+
+it('normalizes a padded batch over the valid samples of each waveform', function () {
+    $extractor = new Wav2Vec2FeatureExtractor(['do_normalize' => true, 'sampling_rate' => 16000]);
+
+    $lengths = [400, 250];
+    $waveforms = array_map(
+        fn(int $length) => Tensor::fromArray(array_map(fn($i) => 0.3 + 0.5 * sin($i / 7), range(0, $length - 1)), Tensor::float32),
+        $lengths
+    );
+
+    ['input_values' => $inputValues, 'attention_mask' => $attentionMask] = $extractor($waveforms);
+
+    expect($inputValues->shape())->toBe([2, 400])
+        ->and($attentionMask->shape())->toBe([2, 400])
+        ->and($attentionMask->dtype())->toBe(Tensor::int64);
+
+    $values = $inputValues->toArray();
+    $mask = $attentionMask->toArray();
+
+    foreach ($lengths as $i => $length) {
+        $valid = array_slice($values[$i], 0, $length);
+        $mean = array_sum($valid) / $length;
+        $variance = array_sum(array_map(fn($x) => ($x - $mean) ** 2, $valid)) / $length;
+
+        expect($mean)->toEqualWithDelta(0.0, 1e-5)
+            ->and($variance)->toEqualWithDelta(1.0, 1e-4)
+            ->and(array_slice($values[$i], $length))->toBe(array_fill(0, 400 - $length, 0.0))
+            ->and($mask[$i])->toBe([...array_fill(0, $length, 1), ...array_fill(0, 400 - $length, 0)]);
+    }
+});
@@ -0,0 +1,63 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\FeatureExtractors\WhisperFeatureExtractor;
+use Codewithkyrian\Transformers\Utils\Audio;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+});
+
+it('extracts the same features from streamed frames as from the whole waveform', function () {
+    $extractor = new WhisperFeatureExtractor([
+        'feature_size' => 80,
+        'sampling_rate' => 16000,
+        'hop_length' => 160,
+        'chunk_length' => 30,
+        'n_fft' => 400,
+        'n_samples' => 480000,
+        'nb_max_frames' => 3000,
+    ]);
+
+    $waveform = (new Audio(__DIR__ . '/../sounds/jfk.wav'))->toTensor(16000);
+
+    // Blocks that do not line up with the hop length
+    $blocks = (function () use ($waveform) {
+        for ($offset = 0; $offset < $waveform->size(); $offset += 4001) {
+            yield $waveform->sliceWithBounds([$offset], [min(4001, $waveform->size() - $offset)]);
+        }
+    })();
+
+    $frames = iterator_to_array($extractor->extractFrames($blocks), false);
+    $streamed = $extractor->framesToFeatures($frames)['input_features'];
+    $whole = $extractor($waveform)['input_features'];
+
+    expect($streamed->shape())->toBe([1, 80, 3000])
+        ->and($whole->shape())->toBe([1, 80, 3000]);
+
+    // The last frames of the audio see reflect padding when streamed but zeros in the whole 30s waveform, so
+    // they are left out. Past them, the zeros are exactly the log-mel of silence the streamed frames are padded with.
+    $numFrames = 1 + intdiv($waveform->size(), 160);
+    $streamed = $streamed->toArray()[0];
+    $whole = $whole->toArray()[0];
+
+    $maxDiff = 0.0;
+    $maxPaddingDiff = 0.0;
+    for ($i = 0; $i < 80; $i++) {
+        for ($t = 0; $t < 3000; $t++) {
+            $diff = abs($streamed[$i][$t] - $whole[$i][$t]);
+
+            if ($t < $numFrames - 3) {
+                $maxDiff = max($maxDiff, $diff);
+            } elseif ($t >= $numFrames + 3) {
+                $maxPaddingDiff = max($maxPaddingDiff, $diff);
+            }
+        }
+    }
+
+    expect($maxDiff)->toBeLessThan(1e-4)
+        ->and($maxPaddingDiff)->toBeLessThan(1e-6);
+});
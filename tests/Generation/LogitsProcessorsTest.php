@@ -0,0 +1,118 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\Configs\GenerationConfig;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\ForcedBOSTokenLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\ForcedEOSTokenLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\MinLengthLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\MinNewTokensLengthLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\NoBadWordsLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\NoRepeatNGramLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\RepetitionPenaltyLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\SuppressTokensAtBeginLogitsProcessor;
+use Codewithkyrian\Transformers\Generation\LogitsProcessors\WhisperTimeStampLogitsProcessor;
+use Codewithkyrian\Transformers\Tensor\Tensor;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+
+    $this->row = [-2.0, 4.0, 1.0, 1.0, 1.0, 1.0];
+
+    // The `[batch, 1, vocab]` logits of the last step, as passed in by generate()
+    $this->logits = fn(array ...$rows) => new Tensor(array_map(fn($row) => [$row], $rows), Tensor::float32);
+});
+
+/**
+ * Every processor below touches only the rows of the sequences its rule applies to, so the
+ * second row must come out the same as it went in.
+ */
+it('forces the BOS token only on sequences at their first step', function () {
+    $processed = (new ForcedBOSTokenLogitsProcessor(2))([[0], [0, 1]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-INF, -INF, 0.0, -INF, -INF, -INF]],
+        [$this->row],
+    ]);
+});
+
+it('forces the EOS token once a sequence is one token short of the max length', function () {
+    $processed = (new ForcedEOSTokenLogitsProcessor(4, 5))([[0, 1, 2], [0, 1]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-INF, -INF, -INF, -INF, -INF, 0.0]],
+        [$this->row],
+    ]);
+});
+
+it('suppresses EOS only on sequences below the min length', function () {
+    $processed = (new MinLengthLogitsProcessor(3, 5))([[0, 1], [0, 1, 2]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-2.0, 4.0, 1.0, 1.0, 1.0, -INF]],
+        [$this->row],
+    ]);
+});
+
+it('suppresses EOS only on sequences with too few new tokens', function () {
+    $processed = (new MinNewTokensLengthLogitsProcessor(1, 2, [5]))([[0, 1], [0, 1, 2]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-2.0, 4.0, 1.0, 1.0, 1.0, -INF]],
+        [$this->row],
+    ]);
+});
+
+it('bans the last token of a bad word only after its prefix', function () {
+    $processed = (new NoBadWordsLogitsProcessor([[1, 4]], 5))([[0, 1], [0, 2]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-2.0, 4.0, 1.0, 1.0, -INF, 1.0]],
+        [$this->row],
+    ]);
+});
+
+it('bans repeated n-grams per sequence', function () {
+    $processed = (new NoRepeatNGramLogitsProcessor(2))([[1, 2, 1], [1, 2, 3]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-2.0, 4.0, -INF, 1.0, 1.0, 1.0]],
+        [$this->row],
+    ]);
+});
+
+it('penalizes the tokens of each sequence on its own row', function () {
+    $processed = (new RepetitionPenaltyLogitsProcessor(2.0))([[0, 1], [3]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-4.0, 2.0, 1.0, 1.0, 1.0, 1.0]],
+        [[-2.0, 4.0, 1.0, 0.5, 1.0, 1.0]],
+    ]);
+});
+
+it('suppresses tokens only on sequences at the begin index', function () {
+    $processed = (new SuppressTokensAtBeginLogitsProcessor([0, 5], 2))([[0, 1], [0]], ($this->logits)($this->row, $this->row));
+
+    expect($processed->toArray())->toBe([
+        [[-INF, 4.0, 1.0, 1.0, 1.0, -INF]],
+        [$this->row],
+    ]);
+});
+
+it('applies the Whisper timestamp rules per sequence', function () {
+    // eos = 1, <|notimestamps|> = 3, so timestamps begin at 4 and the first one is due after one token
+    $processor = new WhisperTimeStampLogitsProcessor(new GenerationConfig([
+        'eos_token_id' => 1,
+        'no_timestamps_token_id' => 3,
+    ]));
+
+    $row = [5.0, 5.0, 5.0, 0.0, 0.0, 0.0, 0.0, 0.0];
+    $processed = $processor([[0], [0, 2, 2]], ($this->logits)($row, $row));
+
+    expect($processed->toArray())->toBe([
+        [[-INF, -INF, -INF, -INF, 0.0, -INF, -INF, -INF]],
+        [[5.0, 5.0, 5.0, -INF, 0.0, 0.0, 0.0, 0.0]],
+    ]);
+});
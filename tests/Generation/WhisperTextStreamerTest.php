@@ -0,0 +1,51 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\Generation\Streamers\WhisperTextStreamer;
+use Codewithkyrian\Transformers\PreTrainedTokenizers\AutoTokenizer;
+
+beforeEach(function () {
+    $this->tokenizer = AutoTokenizer::fromPretrained('Xenova/whisper-tiny');
+    $this->timestampBegin = $this->tokenizer->model->convertTokensToIds(["<|notimestamps|>"])[0] + 1;
+
+    $this->streamed = [];
+    $this->timestamps = [];
+    $this->chunkEnds = [];
+
+    $this->streamer = WhisperTextStreamer::make()
+        ->onStream(fn($text) => $this->streamed[] = $text)
+        ->onTimestampStart(fn($time) => $this->timestamps[] = $time)
+        ->onChunkEnd(fn($text) => $this->chunkEnds[] = $text)
+        ->setTokenizer($this->tokenizer)
+        ->setTimePrecision(0.02)
+        ->setTimestampBegin($this->timestampBegin);
+});
+
+it('discards the partial tokens of a restarted chunk', function () {
+    $first = $this->tokenizer->encode(' Hello world.', addSpecialTokens: false);
+    $second = $this->tokenizer->encode(' Goodbye.', addSpecialTokens: false);
+
+    $this->streamer->put([$first]);
+    $this->streamer->restartChunk(5.0)->put([$second]);
+
+    expect($this->streamed)->toBe([' Hello world.', ' Goodbye.']);
+});
+
+it('offsets timestamps by the start of the restarted chunk', function () {
+    $tokens = $this->tokenizer->encode(' Goodbye.', addSpecialTokens: false);
+
+    $this->streamer->restartChunk(5.0)->put([[...$tokens, $this->timestampBegin + 50]]);
+
+    expect($this->timestamps)->toHaveCount(1)
+        ->and($this->timestamps[0])->toEqualWithDelta(6.0, 1e-6);
+});
+
+it('reports the finalized text when a chunk ends', function () {
+    $tokens = $this->tokenizer->encode(' Goodbye.', addSpecialTokens: false);
+
+    $this->streamer->put([$tokens]);
+    $this->streamer->putChunk(['tokens' => $tokens, 'stride' => [3.0, 0, 0], 'is_last' => true]);
+
+    expect($this->chunkEnds)->toBe([' Goodbye.']);
+});
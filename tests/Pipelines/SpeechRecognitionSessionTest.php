@@ -0,0 +1,129 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\Generation\Streamers\WhisperTextStreamer;
+use Codewithkyrian\Transformers\Pipelines\SpeechRecognitionSession;
+use Codewithkyrian\Transformers\Transformers;
+use Codewithkyrian\Transformers\Utils\Audio;
+use function Codewithkyrian\Transformers\Pipelines\pipeline;
+
+beforeAll(function () {
+    Transformers::setup()
+        ->setCacheDir('tests/models')
+        ->apply();
+});
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+
+    $this->path = __DIR__ . '/../sounds/jfk.wav';
+
+    // 11 seconds at 16kHz
+    $this->samples = (new Audio($this->path))->toTensor(16000);
+
+    // Reads the protected state of a session
+    $this->state = fn(SpeechRecognitionSession $session, string $property) => (fn() => $this->$property)->call($session);
+});
+
+describe('CTC sessions', function () {
+    beforeEach(function () {
+        $this->transcriber = pipeline('automatic-speech-recognition', 'Xenova/wav2vec2-base-960h');
+    });
+
+    it('finalizes a segment every chunk length minus the left context', function () {
+        // 5 second segments with 1 second of left context, a partial hypothesis every second
+        $session = $this->transcriber->session(chunkLengthSecs: 6, strideLengthSecs: 1, hopLengthSecs: 1);
+
+        $finals = [];
+        $partials = 0;
+
+        for ($offset = 0; $offset < $this->samples->size(); $offset += 4000) {
+            $block = $this->samples->sliceWithBounds([$offset], [min(4000, $this->samples->size() - $offset)]);
+            $hypothesis = $session->push($block);
+
+            // Only the unfinished segment and its left context are kept
+            $received = $offset + $block->size();
+            $bufferStart = ($this->state)($session, 'bufferStart');
+
+            expect(($this->state)($session, 'buffer')?->size() ?? 0)->toBe($received - $bufferStart)
+                ->and($received - $bufferStart)->toBeLessThanOrEqual(96000);
+
+            if ($hypothesis === null) {
+                continue;
+            }
+
+            if ($hypothesis['is_final']) {
+                $finals[] = $received;
+            } else {
+                $partials++;
+            }
+        }
+
+        // Partials every second, except where a segment is finalized, and for the last second if it is whole
+        expect($finals)->toBe([80000, 160000])
+            ->and($partials)->toBe($this->samples->size() >= 176000 ? 9 : 8)
+            ->and(($this->state)($session, 'bufferStart'))->toBe(144000);
+
+        $oneShot = ($this->transcriber)($this->path)['text'];
+        $streamed = $session->finish()['text'];
+
+        similar_text($oneShot, $streamed, $percent);
+
+        expect($streamed)->toStartWith('AND SO MY FELLOW AMERICANS')
+            ->and($percent)->toBeGreaterThan(95.0);
+    });
+
+    it('drops the frames of the left context', function () {
+        $session = $this->transcriber->session(chunkLengthSecs: 6, strideLengthSecs: 1, hopLengthSecs: 10);
+
+        $session->push($this->samples->sliceWithBounds([0], [160000]));
+
+        // Two segments of 5 seconds at 50 frames per second, without the second one's 1 second of context
+        expect(abs(count(($this->state)($session, 'frameIds')) - 500))->toBeLessThanOrEqual(4);
+    });
+
+    it('decodes silence when nothing was pushed', function () {
+        $session = $this->transcriber->session();
+
+        expect($session->finish())->toBe(['text' => ''])
+            ->and($session->finish())->toBe(['text' => '']);
+    });
+
+    it('refuses audio after the session is finished', function () {
+        $session = $this->transcriber->session();
+        $session->finish();
+
+        $session->push([0.0, 0.0]);
+    })->throws(InvalidArgumentException::class);
+});
+
+describe('Whisper sessions', function () {
+    it('streams partial hypotheses and ends a chunk per segment', function () {
+        $transcriber = pipeline('automatic-speech-recognition', 'Xenova/whisper-tiny.en');
+
+        $chunkEnds = [];
+        $streamer = WhisperTextStreamer::make()
+            ->onChunkEnd(function ($text) use (&$chunkEnds) {
+                $chunkEnds[] = $text;
+            });
+
+        // 8 second segments with 2 seconds of left context
+        $session = $transcriber->session(chunkLengthSecs: 10, strideLengthSecs: 2, hopLengthSecs: 2, streamer: $streamer);
+
+        $finals = 0;
+        for ($offset = 0; $offset < $this->samples->size(); $offset += 16000) {
+            $block = $this->samples->sliceWithBounds([$offset], [min(16000, $this->samples->size() - $offset)]);
+            $finals += ($session->push($block)['is_final'] ?? false) ? 1 : 0;
+        }
+
+        $output = $session->finish();
+
+        expect($finals)->toBe(1)
+            ->and($chunkEnds)->toHaveCount(2)
+            ->and(strtolower($output['text']))->toContain('fellow americans')
+            ->and(strtolower($chunkEnds[0]))->toContain('fellow americans');
+    });
+});
@@ -0,0 +1,52 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\Transformers;
+use Codewithkyrian\Transformers\Utils\Audio;
+use Codewithkyrian\Transformers\Utils\ResampleQuality;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+
+    // 11 seconds of 16-bit stereo at 44.1kHz
+    $this->path = __DIR__ . '/../sounds/jfk.wav';
+});
+
+it('down-mixes stereo to mono at the source sample rate', function () {
+    $samples = (new Audio($this->path))->toTensor(44100);
+
+    // Frame 10000 holds (-645, -654)
+    expect($samples->shape())->toBe([485100])
+        ->and($samples->buffer()[10000])->toEqualWithDelta((-645 - 654) / 32768 * sqrt(2) / 2, 1e-6);
+});
+
+it('resamples to 16kHz with every quality', function (ResampleQuality $quality) {
+    $samples = (new Audio($this->path))->toTensor(16000, quality: $quality);
+
+    expect(abs($samples->size() - 176000))->toBeLessThanOrEqual(2);
+
+    $streamed = 0;
+    foreach ((new Audio($this->path))->stream(16000, quality: $quality) as $block) {
+        $streamed += $block->size();
+    }
+
+    expect($streamed)->toBe($samples->size());
+})->with(ResampleQuality::cases());
+
+it('loads batches the same with worker processes', function () {
+    $serial = Audio::loadBatch([$this->path, $this->path], 16000);
+
+    Transformers::setup()->setAudioWorkers(2);
+
+    try {
+        $parallel = Audio::loadBatch([$this->path, $this->path], 16000);
+    } finally {
+        Transformers::setup()->setAudioWorkers(1);
+    }
+
+    expect($parallel)->toHaveCount(2)
+        ->and($parallel[1]->toArray())->toBe($serial[1]->toArray());
+});
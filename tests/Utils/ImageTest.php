@@ -73,3 +73,49 @@ describe('VIPS Driver', function () {
         unlink($tmp);
     });
 });
+
+describe('GD Driver', function () {
+    beforeEach(function () {
+        if (!extension_loaded('gd')) {
+            $this->markTestSkipped('GD extension is not loaded.');
+        }
+
+        Image::setDriver(ImageDriver::GD);
+    });
+
+    afterEach(function () {
+        Image::setDriver(ImageDriver::VIPS);
+    });
+
+    it('reads the same pixels as imagecolorat', function () {
+        $img = Image::read('tests/fixtures/images/sample.jpg')->resize(16, 8)->rgb();
+        $tensor = $img->toTensor('HWC');
+        $gdResource = $img->image->getGdResource();
+
+        foreach ([[0, 0], [15, 7], [5, 3]] as [$x, $y]) {
+            $argb = imagecolorat($gdResource, $x, $y);
+
+            expect($tensor[$y][$x]->toArray())->toEqual([($argb >> 16) & 0xFF, ($argb >> 8) & 0xFF, $argb & 0xFF]);
+        }
+    });
+
+    it('reads alpha as whole 8-bit values', function () {
+        $img = Image::read('tests/fixtures/images/sample.jpg')->resize(16, 8)->rgba();
+        $alpha = $img->toTensor('CHW')[3]->toArray();
+
+        foreach ($alpha as $row) {
+            foreach ($row as $value) {
+                expect($value)->toBe(round($value));
+            }
+        }
+    });
+
+    it('round trips pixels through a tensor', function () {
+        $img = Image::read('tests/fixtures/images/sample.jpg')->resize(16, 8)->rgb();
+        $tensor = $img->toTensor('CHW');
+
+        $img2 = Image::fromTensor($tensor, 'CHW');
+
+        expect($img2->getPixelData())->toBe($img->getPixelData());
+    });
+});
@@ -0,0 +1,124 @@
+<?php
+
+declare(strict_types=1);
+
+use Codewithkyrian\Transformers\Tensor\Tensor;
+use Codewithkyrian\Transformers\Utils\Audio;
+use Codewithkyrian\Transformers\Utils\SpectrogramContext;
+use Codewithkyrian\Transformers\Utils\SpectrogramStream;
+use Codewithkyrian\Transformers\Utils\VoiceActivityDetector;
+
+beforeEach(function () {
+    if (!extension_loaded('ffi')) {
+        $this->markTestSkipped('FFI extension is not loaded.');
+    }
+
+    $melFilters = Audio::melFilterBank(201, 80, 0, 8000, 16000, 'slaney', 'slaney');
+
+    $this->context = new SpectrogramContext(
+        Audio::windowFunction(400, 'hann', false),
+        frameLength: 400,
+        hopLength: 160,
+        power: 2.0,
+        melFilters: $melFilters,
+        logMel: 'log10',
+    );
+
+    $this->waveform = fn(int $length, float $frequency) => Tensor::fromArray(
+        array_map(fn($i) => 0.5 * sin(2 * M_PI * $frequency * $i / 16000), range(0, $length - 1)),
+        Tensor::float32
+    );
+});
+
+it('computes a batch of spectrograms like the single waveform path', function () {
+    $waveforms = [($this->waveform)(4000, 440), ($this->waveform)(4000, 880)];
+
+    $batch = $this->context->computeBatch($waveforms);
+
+    expect($batch->shape())->toBe([2, 80, 26]);
+
+    foreach ($waveforms as $i => $waveform) {
+        expect($batch[$i]->toArray())->toEqual($this->context->compute($waveform)->toArray());
+    }
+});
+
+it('zero-pads chunks running past the end of the waveform', function () {
+    $waveform = ($this->waveform)(5000, 440);
+
+    $chunks = $this->context->computeChunks($waveform, [0, 3000], 3000);
+
+    $tail = Tensor::concat([$waveform->sliceWithBounds([3000], [2000]), Tensor::zeros([1000], Tensor::float32)]);
+
+    expect($chunks->shape())->toBe([2, 80, 19])
+        ->and($chunks[0]->toArray())->toEqual($this->context->compute($waveform->sliceWithBounds([0], [3000]))->toArray())
+        ->and($chunks[1]->toArray())->toEqual($this->context->compute($tail)->toArray());
+});
+
+it('rejects batches whose spectrograms differ in shape', function () {
+    $this->context->computeBatch([($this->waveform)(4000, 440), ($this->waveform)(3000, 440)]);
+})->throws(InvalidArgumentException::class);
+
+it('streams the same frames as the centered spectrogram of the whole waveform', function () {
+    $waveform = ($this->waveform)(5000, 440);
+
+    $stream = new SpectrogramStream(new SpectrogramContext(
+        Audio::windowFunction(400, 'hann', false),
+        frameLength: 400,
+        hopLength: 160,
+        power: 2.0,
+        center: false,
+        melFilters: Audio::melFilterBank(201, 80, 0, 8000, 16000, 'slaney', 'slaney'),
+        logMel: 'log10',
+    ));
+
+    $frames = [];
+    foreach ([0, 150, 1200, 3700] as $i => $start) {
+        $end = [150, 1200, 3700, 5000][$i];
+        $frames[] = $stream->push($waveform->sliceWithBounds([$start], [$end - $start]));
+    }
+    $frames[] = $stream->finish();
+
+    $streamed = Tensor::concat(array_values(array_filter($frames)), 1);
+
+    expect($streamed->shape())->toBe([80, 32])
+        ->and($streamed->toArray())->toEqualWithDelta($this->context->compute($waveform)->toArray(), 1e-4);
+});
+
+it('shares mel filter tensors matching the filter bank arrays', function () {
+    $melFilters = Audio::melFilterTensor(201, 80, 0, 8000, 16000, 'slaney', 'slaney');
+
+    expect($melFilters)->toBe(Audio::melFilterTensor(201, 80, 0, 8000, 16000, 'slaney', 'slaney'))
+        ->and($melFilters->shape())->toBe([80, 201])
+        ->and($melFilters->toArray())->toEqualWithDelta(Audio::melFilterBank(201, 80, 0, 8000, 16000, 'slaney', 'slaney'), 1e-6);
+
+    $context = new SpectrogramContext(
+        Audio::windowFunction(400, 'hann', false),
+        frameLength: 400,
+        hopLength: 160,
+        power: 2.0,
+        melFilters: $melFilters,
+        logMel: 'log10',
+    );
+
+    $waveform = ($this->waveform)(4000, 440);
+
+    expect($context->compute($waveform)->toArray())->toEqual($this->context->compute($waveform)->toArray());
+});
+
+it('finds the voiced segments of audio with silence around them', function () {
+    $silence = Tensor::zeros([16000], Tensor::float32);
+    $waveform = Tensor::concat([$silence, ($this->waveform)(16000, 440), $silence, ($this->waveform)(8000, 880), $silence]);
+
+    $segments = (new VoiceActivityDetector(16000))->segments($waveform);
+
+    expect($segments)->toHaveCount(2)
+        ->and($segments[0][0])->toBeGreaterThan(12000)->toBeLessThan(16000)
+        ->and($segments[0][1])->toBeGreaterThan(32000)->toBeLessThan(36000)
+        ->and($segments[1][0])->toBeGreaterThan(44000)->toBeLessThan(48000);
+
+    $split = (new VoiceActivityDetector(16000))->segments($waveform, 8000);
+
+    foreach ($split as [$start, $end]) {
+        expect($end - $start)->toBeLessThanOrEqual(8000);
+    }
+});
@@ -5,6 +5,7 @@ declare(strict_types=1);
 namespace Codewithkyrian\Transformers\Utils;
 
 use Codewithkyrian\Transformers\Tensor\Tensor;
+use InvalidArgumentException;
 use OutOfRangeException;
 
 describe('Tensor creation', function () {
@@ -41,6 +42,22 @@ describe('Tensor creation', function () {
         expect($t->toArray())->toBe([1.0, 2.0, 3.0, 4.0]);
     });
 
+    it('round-trips nested int, bool and float arrays', function () {
+        $ids = [[101, 2023, 102, 0], [101, 7592, 2088, 102]];
+        expect((new Tensor($ids, Tensor::int64))->toArray())->toBe($ids)
+            ->and((new Tensor([[true, false], [false, true]], Tensor::bool))->toArray())->toBe([[true, false], [false, true]])
+            ->and((new Tensor([[[0.5], [1.5]], [[2.5], [3.5]]]))->toArray())->toBe([[[0.5], [1.5]], [[2.5], [3.5]]]);
+    });
+
+    it('converts a tensor view to an array', function () {
+        $t = new Tensor([[1, 2, 3], [4, 5, 6]], Tensor::int32);
+        expect($t[1]->toArray())->toBe([4, 5, 6]);
+    });
+
+    it('rejects ragged arrays', function () {
+        expect(fn() => new Tensor([[1, 2], [3]]))->toThrow(InvalidArgumentException::class);
+    });
+
     it('can create a tensor from repeating another tensor', function () {
         $t = new Tensor([1.0, 2.0, 3.0]);
         $repeated = Tensor::repeat($t, 3);
@@ -62,6 +79,27 @@ describe('Tensor creation', function () {
         expect($unserialized)->toBeInstanceOf(Tensor::class)
             ->and($unserialized->toArray())->toBe([1.0, 2.0, 3.0, 4.0]);
     });
+
+    it('can be saved to and loaded from a .npy file', function (bool $mmap) {
+        $path = tempnam(sys_get_temp_dir(), 'tensor');
+        $t = new Tensor([[1, 2, 3], [4, 5, 6]], Tensor::int64);
+
+        $t->save($path);
+        $loaded = Tensor::load($path, $mmap);
+
+        $contents = file_get_contents($path);
+        $dataOffset = 10 + unpack('v', substr($contents, 8, 2))[1];
+
+        expect(substr($contents, 0, 6))->toBe("\x93NUMPY")
+            ->and($dataOffset % 64)->toBe(0)
+            ->and(strlen($contents))->toBe($dataOffset + 6 * 8)
+            ->and($loaded->shape())->toBe([2, 3])
+            ->and($loaded->dtype())->toBe(Tensor::int64)
+            ->and($loaded->toArray())->toBe([[1, 2, 3], [4, 5, 6]]);
+
+        unset($loaded);
+        unlink($path);
+    })->with([true, false]);
 });
 
 describe('Mathematical Operations', function () {
@@ -271,6 +309,43 @@ describe('Statistical operations', function () {
 //            ->and($mean)->toEqualWithDelta(3.0, 1e-4);
 //    })->todo();
 
+    it('can calculate standard deviation and mean along an axis', function () {
+        $t = new Tensor([[1.0, 2.0, 3.0], [2.0, 4.0, 6.0]]);
+        [$std, $mean] = $t->stdMean(1, 0);
+
+        expect($mean->toArray())->toMatchArrayApproximately([2.0, 4.0])
+            ->and($std->toArray())->toMatchArrayApproximately([0.8164966, 1.6329932], 1e-6);
+    });
+
+    it('can calculate the norm along an axis', function () {
+        $t = new Tensor([[3.0, 4.0], [-6.0, 8.0]]);
+
+        expect($t->norm(2, 1)->toArray())->toMatchArrayApproximately([5.0, 10.0])
+            ->and($t->norm(1, 1)->toArray())->toMatchArrayApproximately([7.0, 14.0])
+            ->and($t->norm(2, 0, true)->shape())->toBe([1, 2]);
+    });
+
+    it('can normalize along an axis', function () {
+        $t = new Tensor([[3.0, 4.0], [-6.0, 8.0]]);
+
+        expect($t->normalize(2, -1)->reshape([4])->toArray())->toMatchArrayApproximately([0.6, 0.8, -0.6, 0.8], 1e-6)
+            ->and($t->normalize(2, 0)->reshape([4])->toArray())->toMatchArrayApproximately([0.4472136, 0.4472136, -0.8944272, 0.8944272], 1e-6)
+            ->and($t->toArray())->toBe([[3.0, 4.0], [-6.0, 8.0]]);
+    });
+
+    it('can mean pool hidden states with an attention mask', function () {
+        $hiddenStates = new Tensor([
+            [[1.0, 2.0], [3.0, 4.0], [100.0, 100.0]],
+            [[1.0, 1.0], [2.0, 2.0], [3.0, 3.0]],
+        ]);
+        $attentionMask = new Tensor([[1, 1, 0], [1, 1, 1]], Tensor::int64);
+
+        expect($hiddenStates->meanPooling($attentionMask)->reshape([4])->toArray())
+            ->toMatchArrayApproximately([2.0, 3.0, 2.0, 2.0], 1e-6)
+            ->and($hiddenStates->lastTokenPooling($attentionMask)->toArray())
+            ->toBe([[3.0, 4.0], [3.0, 3.0]]);
+    });
+
     it('can calculate cosine similarity', function () {
         $t1 = new Tensor([1.0, 2.0, 3.0]);
         $t2 = new Tensor([4.0, 5.0, 6.0]);
@@ -290,6 +365,22 @@ describe('Statistical operations', function () {
         expect($values->toArray())->toBe([5.0, 4.0, 3.0])
             ->and($indices->toArray())->toBe([4, 1, 2]);
     });
+
+    it('can find top k values along any axis', function () {
+        $t = new Tensor([
+            [[1.0, 9.0], [5.0, 2.0], [3.0, 7.0]],
+            [[8.0, 0.0], [4.0, 6.0], [2.0, 1.0]],
+        ]);
+
+        [$values, $indices] = $t->topk(2);
+        expect($values->shape())->toBe([2, 3, 2])
+            ->and($indices->dtype())->toBe(Tensor::int64)
+            ->and($indices->toArray())->toBe([[[1, 0], [0, 1], [1, 0]], [[0, 1], [1, 0], [0, 1]]]);
+
+        [$values, $indices] = $t->topk(2, axis: 1);
+        expect($values->toArray())->toBe([[[5.0, 9.0], [3.0, 7.0]], [[8.0, 6.0], [4.0, 1.0]]])
+            ->and($indices->toArray())->toBe([[[1, 0], [2, 2]], [[0, 1], [1, 2]]]);
+    });
 });
 
 describe('Error handling', function () {
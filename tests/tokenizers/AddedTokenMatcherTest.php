@@ -0,0 +1,63 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Tests;
+
+use Codewithkyrian\Transformers\Tokenizers\AddedToken;
+use Codewithkyrian\Transformers\Tokenizers\AddedTokenMatcher;
+
+describe('AddedTokenMatcher', function () {
+    it('splits on the leftmost-longest added token', function () {
+        $matcher = new AddedTokenMatcher([
+            new AddedToken('<|end|>', 1),
+            new AddedToken('<|endoftext|>', 2),
+            new AddedToken('<|im_start|>', 3),
+        ]);
+
+        $sections = $matcher->split('Hi<|endoftext|><|im_start|>there<|end|>');
+
+        expect(array_column($sections, 0))->toBe(['Hi', '<|endoftext|>', '<|im_start|>', 'there', '<|end|>'])
+            ->and(array_map(fn($x) => $x[1]?->id, $sections))->toBe([null, 2, 3, null, 1]);
+    });
+
+    it('matches tokens that are a suffix of the prefix of another token', function () {
+        // The state of "ba" fails over to "a" without ending a pattern itself
+        $matcher = new AddedTokenMatcher([new AddedToken('bac', 1), new AddedToken('a', 2)]);
+
+        $sections = $matcher->split('xbacyba');
+
+        expect(array_column($sections, 0))->toBe(['x', 'bac', 'yb', 'a'])
+            ->and(array_map(fn($x) => $x[1]?->id, $sections))->toBe([null, 1, null, 2]);
+
+        $matcher = new AddedTokenMatcher([new AddedToken('bac', 1), new AddedToken('a', 2), new AddedToken('ba', 3)]);
+
+        $sections = $matcher->split('xbacyba');
+
+        expect(array_column($sections, 0))->toBe(['x', 'bac', 'y', 'ba'])
+            ->and(array_map(fn($x) => $x[1]?->id, $sections))->toBe([null, 1, null, 3]);
+    });
+
+    it('strips whitespace around tokens that ask for it', function () {
+        $matcher = new AddedTokenMatcher([
+            new AddedToken('<mask>', 1, lStrip: true),
+            new AddedToken('</s>', 2, rStrip: true),
+        ]);
+
+        expect(array_column($matcher->split('Paris is the <mask> of France.</s>  Next'), 0))
+            ->toBe(['Paris is the', '<mask>', ' of France.', '</s>', 'Next']);
+    });
+
+    it('only matches single-word tokens outside of words', function () {
+        $matcher = new AddedTokenMatcher([new AddedToken('cat', 1, singleWord: true)]);
+
+        expect(array_column($matcher->split('a cat, a concatenation'), 0))
+            ->toBe(['a ', 'cat', ', a concatenation']);
+    });
+
+    it('matches transformed patterns', function () {
+        $matcher = new AddedTokenMatcher([new AddedToken('[NEW]', 7)], fn($x) => strtolower($x));
+
+        expect(array_column($matcher->split('a [new] b'), 0))->toBe(['a ', '[NEW]', ' b']);
+    });
+});
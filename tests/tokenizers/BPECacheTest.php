@@ -0,0 +1,45 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Tests;
+
+use Codewithkyrian\Transformers\Tokenizers\BPECache;
+
+describe('BPECache', function () {
+    it('evicts the least recently used entries', function () {
+        $cache = new BPECache('test', maxEntries: 2);
+
+        $cache->set('hello', ['hel', 'lo']);
+        $cache->set('world', ['wor', 'ld']);
+
+        // Touch "hello" so that "world" becomes the least recently used entry
+        expect($cache->get('hello'))->toBe(['hel', 'lo']);
+
+        $cache->set('again', ['again']);
+
+        expect($cache->get('world'))->toBeNull()
+            ->and($cache->get('again'))->toBe(['again'])
+            ->and($cache->get('hello'))->toBe(['hel', 'lo'])
+            ->and($cache->stats())->toMatchArray(['entries' => 2, 'hits' => 3, 'misses' => 1, 'evictions' => 1]);
+    });
+
+    it('respects the byte limit', function () {
+        $cache = new BPECache('test', maxEntries: 100, maxBytes: 400);
+
+        foreach (range(1, 10) as $i) {
+            $cache->set("token{$i}", ["tok", "en{$i}"]);
+        }
+
+        expect($cache->stats()['bytes'])->toBeLessThanOrEqual(400)
+            ->and($cache->evictions)->toBeGreaterThan(0)
+            ->and($cache->get('token10'))->toBe(['tok', 'en10']);
+    });
+
+    it('does not store anything when disabled', function () {
+        $cache = new BPECache('test', maxEntries: 0);
+        $cache->set('hello', ['hello']);
+
+        expect($cache->get('hello'))->toBeNull();
+    });
+});
@@ -0,0 +1,45 @@
+<?php
+
+declare(strict_types=1);
+
+namespace Tests;
+
+use Codewithkyrian\Transformers\DataStructures\DoubleArray;
+use Codewithkyrian\Transformers\DataStructures\TokenLattice;
+
+describe('DoubleArray', function () {
+    it('finds every key that prefixes the text at a byte offset', function () {
+        $trie = DoubleArray::build(['a' => 0, 'ab' => 1, 'abc' => 2, 'b' => 3, '▁the' => 4, '▁' => 5, '10' => 6]);
+
+        expect($trie->commonPrefixSearch('abcd'))->toBe([1 => 0, 2 => 1, 3 => 2])
+            ->and($trie->commonPrefixSearch('xabd', 1))->toBe([1 => 0, 2 => 1])
+            ->and($trie->commonPrefixSearch('▁them'))->toBe([3 => 5, 6 => 4])
+            ->and($trie->commonPrefixSearch('100'))->toBe([2 => 6])
+            ->and($trie->commonPrefixSearch('zzz'))->toBe([]);
+    });
+
+    it('handles large vocabularies', function () {
+        $entries = [];
+        for ($i = 0; $i < 5000; $i++) {
+            $entries["tok{$i}é"] = $i;
+        }
+
+        $trie = DoubleArray::build($entries);
+
+        expect($trie->commonPrefixSearch('tok4321é!'))->toBe([strlen('tok4321é') => 4321])
+            ->and($trie->commonPrefixSearch('tok4321'))->toBe([]);
+    });
+});
+
+describe('TokenLattice', function () {
+    it('picks the highest scoring segmentation', function () {
+        $lattice = new TokenLattice('abc', null, null);
+        $lattice->insert(0, 1, -1.0, 10);
+        $lattice->insert(1, 1, -1.0, 11);
+        $lattice->insert(2, 1, -1.0, 12);
+        $lattice->insert(0, 2, -1.5, 13);
+
+        expect($lattice->tokens())->toBe(['ab', 'c'])
+            ->and($lattice->tokenIds())->toBe([13, 12]);
+    });
+});
@@ -5,6 +5,8 @@ declare(strict_types=1);
 namespace Tests;
 
 use Codewithkyrian\Transformers\PretrainedTokenizers\AutoTokenizer;
+use Codewithkyrian\Transformers\PretrainedTokenizers\TokenizerSnapshot;
+use Codewithkyrian\Transformers\Tensor\Tensor;
 use Codewithkyrian\Transformers\Transformers;
 
 ini_set('memory_limit', -1);
@@ -211,3 +213,111 @@ describe('Tokenizer padding/truncation', function () {
             ->and($tokenTypeIds->toArray())->toBe([[0, 0], [0, 0], [0, 0]]);
     });
 });
+
+describe('Batch tokenization', function () {
+    it('packs padded batches on either side', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/bert-base-uncased');
+        $tokenizer->paddingSide = 'left';
+
+        ['input_ids' => $inputIds, 'attention_mask' => $attentionMask] = $tokenizer
+            ->tokenize(['a', 'b c'], padding: true, addSpecialTokens: false);
+
+        expect($inputIds->toArray())->toBe([[0, 1037], [1038, 1039]])
+            ->and($attentionMask->toArray())->toBe([[0, 1], [1, 1]]);
+    });
+
+    it('encodes large batches the same with worker processes', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/bert-base-uncased');
+        $texts = array_map(fn($i) => "Sentence number $i of a large batch.", range(1, 300));
+
+        $serial = $tokenizer->tokenize($texts, padding: true, returnTensor: false);
+
+        Transformers::setup()->setTokenizerWorkers(4);
+
+        try {
+            $parallel = $tokenizer->tokenize($texts, padding: true, returnTensor: false);
+        } finally {
+            Transformers::setup()->setTokenizerWorkers(1);
+        }
+
+        expect($parallel)->toBe($serial);
+    });
+});
+
+describe('Offset mapping', function () {
+    it('returns the character span of each token', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/bert-base-uncased');
+
+        $encoded = $tokenizer->tokenize('Héllo World! tokenization', returnTensor: false, returnOffsetsMapping: true);
+
+        expect($encoded['offset_mapping'])->toBe([[0, 0], [0, 5], [6, 11], [11, 12], [13, 18], [18, 25], [0, 0]]);
+
+        $encoded = $tokenizer->tokenize('Héllo World! tokenization', returnTensor: false, returnOffsetsMapping: 'bytes');
+
+        expect($encoded['offset_mapping'][1])->toBe([0, 6]);
+    });
+
+    it('returns a padded int32 tensor for batches', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/bert-base-uncased');
+
+        ['offset_mapping' => $offsets] = $tokenizer->tokenize(['a', 'b c'], padding: true, returnOffsetsMapping: true);
+
+        expect($offsets->shape())->toBe([2, 4, 2])
+            ->and($offsets->dtype())->toBe(Tensor::int32)
+            ->and($offsets->toArray())->toBe([
+                [[0, 0], [0, 1], [0, 0], [0, 0]],
+                [[0, 0], [0, 1], [2, 3], [0, 0]],
+            ]);
+    });
+
+    it('pads the offsets of tokenizers without token type ids', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/gpt2');
+
+        $encoded = $tokenizer->tokenize(['a', 'b c'], padding: true, returnTensor: false, returnOffsetsMapping: true);
+
+        expect($encoded['token_type_ids'])->toBe([null, null])
+            ->and($encoded['input_ids'][0])->toHaveCount(2)
+            ->and($encoded['offset_mapping'][0])->toBe([[0, 1], [0, 0]])
+            ->and($encoded['offset_mapping'][1])->toHaveCount(2);
+    });
+});
+
+describe('Tokenizer snapshots', function () {
+    it('restores a tokenizer from its snapshot', function () {
+        $built = AutoTokenizer::fromPretrained('Xenova/bert-base-uncased');
+
+        $snapshot = TokenizerSnapshot::forModel('Xenova/bert-base-uncased');
+
+        expect($snapshot->save($built))->toBeTrue();
+
+        $restored = $snapshot->load();
+
+        expect($restored)->toBeInstanceOf($built::class)
+            ->and($restored->encode('Hello world, snapshots!'))->toBe($built->encode('Hello world, snapshots!'))
+            ->and($restored->decode($built->encode('Hello world')))->toBe($built->decode($built->encode('Hello world')));
+    });
+
+    it('ignores a stale snapshot', function () {
+        $snapshot = TokenizerSnapshot::forModel('Xenova/bert-base-uncased');
+        $stale = new TokenizerSnapshot($snapshot->path, str_repeat('0', 40));
+
+        expect($stale->load())->toBeNull();
+    });
+});
+
+describe('Whisper ASR decoding', function () {
+    it('does not merge chunks that carry their own offset', function () {
+        $tokenizer = AutoTokenizer::fromPretrained('Xenova/whisper-tiny');
+
+        // Both segments contain " on the mat," which would be taken for an overlap of strided chunks
+        $first = $tokenizer->encode(' The cat sat on the mat, quietly.', addSpecialTokens: false);
+        $second = $tokenizer->encode(' Later on the mat, the dog slept.', addSpecialTokens: false);
+
+        [$text] = $tokenizer->decodeASR([
+            ['tokens' => $first, 'stride' => [3.0, 0, 0], 'offset' => 1.0],
+            ['tokens' => $second, 'stride' => [3.0, 0, 0], 'offset' => 6.0],
+        ], timePrecision: 0.02, forceFullSequences: false);
+
+        expect($text)->toBe(' The cat sat on the mat, quietly. Later on the mat, the dog slept.');
+    });
+});